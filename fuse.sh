@@ -66,14 +66,18 @@ let BL1_POSITION=${BLOCK_CNT}-${BL1_OFFSET}-${BL1_SIZE}-2
 let BL2_POSITION=${BL1_POSITION}-${BL2_SIZE}-${ENV_SIZE}
 
 # ----------------------------------------------------------
-# Create a binary for movinand/mmc boot
+# Fuse the binary for movinand/mmc boot, BL1 only copies as many blocks as the
+# image size in its header asks for
 
-# pad to 256k
-dd if=/dev/zero bs=1k count=256 2> /dev/null | tr "\000" "\377" > build/nanoboot-256k.bin
-dd if=build/nanoboot.bin of=build/nanoboot-256k.bin conv=notrunc 2> /dev/null
+IMAGE_SIZE=`stat -c %s build/nanoboot.bin`
+if [ ${IMAGE_SIZE} -gt $((${BL2_SIZE} * 512)) ]; then
+	echo "error: build/nanoboot.bin is larger than $((${BL2_SIZE} / 2))k"
+	exit 1
+fi
 
-dd if=build/nanoboot-256k.bin of=/dev/${DEV_NAME} bs=512 seek=${BL2_POSITION} conv=fdatasync &> /dev/null
-dd if=build/nanoboot-256k.bin of=/dev/${DEV_NAME} bs=512 seek=${BL1_POSITION} count=16 conv=fdatasync &> /dev/null
-rm build/nanoboot-256k.bin
+dd if=build/nanoboot.bin of=/dev/${DEV_NAME} bs=512 seek=${BL2_POSITION} conv=sync,fdatasync &> /dev/null
+let ENV_POSITION=${BL2_POSITION}+${BL2_SIZE}
+dd if=/dev/zero of=/dev/${DEV_NAME} bs=512 seek=${ENV_POSITION} count=${ENV_SIZE} conv=fdatasync &> /dev/null
+dd if=build/nanoboot.bin of=/dev/${DEV_NAME} bs=512 seek=${BL1_POSITION} count=16 conv=sync,fdatasync &> /dev/null
 
 echo "nanoboot fused"
@@ -33,6 +33,9 @@
 #define ATAG_VIDEOLFB   0x54410008
 #define ATAG_CMDLINE    0x54410009
 
+/* nanoboot's own tags */
+#define ATAG_BOOTLOG    0x4e420001
+
 /* structures for each atag */
 struct atag_header {
         u32 size; /* length of tag in words including this header */
@@ -103,6 +106,12 @@ struct atag_cmdline {
         char    cmdline[1];
 };
 
+/* where the RAM log is, see src/log.h for its layout */
+struct atag_bootlog {
+        u32 start;
+        u32 size;
+};
+
 struct atag {
         struct atag_header hdr;
         union {
@@ -115,6 +124,7 @@ struct atag {
                 struct atag_revision     revision;
                 struct atag_videolfb     videolfb;
                 struct atag_cmdline      cmdline;
+                struct atag_bootlog      bootlog;
         } u;
 };
 
@@ -20,6 +20,26 @@
 
 #define CONFIG_PM
 
+/* read the card with the native HSMMC driver instead of the iROM helper */
+#define CONFIG_HSMMC
+/* negotiate a 4-bit bus and high-speed timing with the card */
+#define CONFIG_HSMMC_HIGHSPEED
+/* run with the MMU and D-cache on while loading */
+#define CONFIG_MMU
+/* keep image extents in the ENV blocks, enabled by "extent_cache" */
+#define CONFIG_EXTENTS
+/* keep printf output in a RAM ring and pass it to the kernel in an ATAG */
+#define CONFIG_LOG
+
+#ifdef CONFIG_HOST
+/* the host simulation build has no caches to manage */
+#undef CONFIG_MMU
+#endif
+
+#if defined(CONFIG_EXTENTS) && !defined(CONFIG_HSMMC)
+# error CONFIG_EXTENTS needs CONFIG_HSMMC to write the manifest
+#endif
+
 //#define CONFIG_CLK_534_133_66
 #define CONFIG_CLK_400_133_66
 //#define CONFIG_CLK_267_133_66
@@ -55,6 +75,9 @@
 # error Must define CONFIG_CLK_534_133_66, CONFIG_CLK_400_133_66, or CONFIG_CLK_267_133_66
 #endif
 
+/* crystal input to the PLLs */
+#define CONFIG_SYS_CLK_FREQ	12000000
+
 #define CLK_DIV_VAL	((Startup_ARMCLKdiv<<9)|(Startup_PREdiv<<4)|(Startup_PCLKdiv<<2)|(Startup_HCLKdiv)|(1<<3))
 #define MPLL_VAL	((Startup_EPLLSTOP<<24)|(Startup_MDIV<<14)|(Startup_PDIV<<5)|(Startup_SDIV))
 #define EPLL_VAL	(32<<16)|(1<<8)|(2<<0)
@@ -82,4 +105,8 @@
 /* base address for nanoboot */
 #define CFG_NANOBOOT_BASE		0x33e00000
 
+/* RAM log, the top of nanoboot's memory, kept from the kernel */
+#define CFG_LOG_SIZE			(64*1024)
+#define CFG_LOG_BASE			(CFG_NANOBOOT_BASE + CFG_NANOBOOT_SIZE - CFG_LOG_SIZE)
+
 #endif /* __CONFIG_H */
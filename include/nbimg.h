@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __NBIMG_H
+#define __NBIMG_H
+
+#include <asm/types.h>
+
+/*
+ * nanoboot image: the kernel, initramfs, device tree and command line packed
+ * into one file so they can be loaded with a single open and a few long
+ * reads.
+ *
+ * The file starts with a header block of NBIMG_ALIGN bytes holding an
+ * nbimg_header followed by its table of nbimg_part entries.  Each part's
+ * data starts at a multiple of NBIMG_ALIGN so it can be read from the card
+ * straight to its load address.  All fields are little endian.
+ */
+
+#define NBIMG_MAGIC         0x474d424e  /* "NBMG" */
+#define NBIMG_VERSION       1
+#define NBIMG_ALIGN         512
+#define NBIMG_MAX_PARTS     7
+
+/* part types */
+#define NBIMG_KERNEL        1
+#define NBIMG_INITRAMFS     2
+#define NBIMG_DTB           3
+#define NBIMG_CMDLINE       4
+
+/* part flags, which checksums are filled in */
+#define NBIMG_CRC32         0x01
+#define NBIMG_SHA256        0x02
+
+struct nbimg_header {
+    __u32 magic;
+    __u32 version;
+    __u32 count;            /* parts in the table */
+    __u32 crc32;            /* of the table */
+};
+
+struct nbimg_part {
+    __u32 type;
+    __u32 flags;
+    __u32 offset;           /* from the start of the file */
+    __u32 size;
+    __u32 load_address;     /* 0 to use nanoboot's own */
+    __u32 crc32;            /* of the data as stored */
+    __u32 reserved[2];
+    __u8 sha256[32];
+};
+
+#endif /* __NBIMG_H */
@@ -760,10 +760,12 @@ typedef enum {
 #define fTCFG0_PRE1		Fld(8,8)        /* prescaler value for time 2,3,4 */
 #define fTCFG0_PRE0		Fld(8,0)        /* prescaler value for time 0,1 */
 #define fTCFG1_MUX4		Fld(4,16)
+#define fTCFG1_MUX0		Fld(4,0)
 /* bits */
 #define TCFG0_DZONE(x)		FInsrt((x), fTCFG0_DZONE)
 #define TCFG0_PRE1(x)		FInsrt((x), fTCFG0_PRE1)
 #define TCFG0_PRE0(x)		FInsrt((x), fTCFG0_PRE0)
+#define TCFG1_MUX0(x)		FInsrt((x), fTCFG1_MUX0)
 #define TCON_4_AUTO		(1 << 22)       /* auto reload on/off for Timer 4 */
 #define TCON_4_UPDATE		(1 << 21)       /* manual Update TCNTB4 */
 #define TCON_4_ONOFF		(1 << 20)       /* 0: Stop, 1: start Timer 4 */
@@ -781,6 +783,9 @@ typedef enum {
 #define TCON_3_ONOFF		(1 << 16)       /* 0: Stop, 1: start Timer 3 */
 #define TIMER3_ON		(TCON_3_ONOFF*1)
 #define TIMER3_OFF		(FClrBit(TCON, TCON_3_ONOFF))
+#define TCON_0_AUTO		(1 << 3)        /* auto reload on/off for Timer 0 */
+#define TCON_0_UPDATE		(1 << 1)        /* manual Update TCNTB0,TCMPB0 */
+#define TCON_0_ONOFF		(1 << 0)        /* 0: Stop, 1: start Timer 0 */
 /* macros */
 #define GET_PRESCALE_TIMER4(x)	FExtr((x), fTCFG0_PRE1)
 #define GET_DIVIDER_TIMER4(x)	FExtr((x), fTCFG1_MUX4)
@@ -839,11 +844,60 @@ typedef enum {
 #define HM_ACMD12ERRSTS	(ELFIN_HSMMC_BASE+0x3c)
 #define HM_CAPAREG	(ELFIN_HSMMC_BASE+0x40)
 #define HM_MAXCURR	(ELFIN_HSMMC_BASE+0x48)
+#define HM_ADMAERR	(ELFIN_HSMMC_BASE+0x54)
+#define HM_ADMASYSADDR	(ELFIN_HSMMC_BASE+0x58)
 #define HM_CONTROL2	(ELFIN_HSMMC_BASE+0x80)
 #define HM_CONTROL3	(ELFIN_HSMMC_BASE+0x84)
 #define HM_CONTROL4	(ELFIN_HSMMC_BASE+0x8C)
 #define HM_HCVER	(ELFIN_HSMMC_BASE+0xfe)
 
+#define HM_TRNMOD_DMAEN		(1<<0)
+#define HM_TRNMOD_BLKCNTEN	(1<<1)
+#define HM_TRNMOD_ACMD12EN	(1<<2)
+#define HM_TRNMOD_READ		(1<<4)
+#define HM_TRNMOD_MULTIBLK	(1<<5)
+
+#define HM_CMDREG_IDX(x)	((x)<<8)
+#define HM_CMDREG_DATA		(1<<5)
+#define HM_CMDREG_IDXCHK	(1<<4)
+#define HM_CMDREG_CRCCHK	(1<<3)
+#define HM_CMDREG_RSP_NONE	(0<<0)
+#define HM_CMDREG_RSP_136	(1<<0)
+#define HM_CMDREG_RSP_48	(2<<0)
+#define HM_CMDREG_RSP_48B	(3<<0)
+
+#define HM_PRNSTS_CMDINHCMD	(1<<0)
+#define HM_PRNSTS_CMDINHDAT	(1<<1)
+#define HM_PRNSTS_BUFRDEN	(1<<11)
+
+#define HM_HOSTCTL_WIDE4	(1<<1)
+#define HM_HOSTCTL_HSPD		(1<<2)
+#define HM_HOSTCTL_DMASEL_MASK	(3<<3)
+#define HM_HOSTCTL_DMASEL_ADMA2	(2<<3)
+
+#define HM_CLKCON_ICLKEN	(1<<0)
+#define HM_CLKCON_ICLKSTA	(1<<1)
+#define HM_CLKCON_SDCLKEN	(1<<2)
+#define HM_CLKCON_SDCLKSEL(x)	((x)<<8)
+
+#define HM_SWRST_CMD		(1<<1)
+#define HM_SWRST_DAT		(1<<2)
+
+#define HM_NORINT_CMDCMPLT	(1<<0)
+#define HM_NORINT_TRCMPLT	(1<<1)
+#define HM_NORINT_DMA		(1<<3)
+#define HM_NORINT_BUFRDRDY	(1<<5)
+#define HM_NORINT_ERR		(1<<15)
+
+#define HM_CONTROL2_SELBASECLK_MASK	(3<<4)
+#define HM_CONTROL2_SELBASECLK_EPLL	(2<<4)
+
+#define HM_ADMA_VALID		(1<<0)
+#define HM_ADMA_END		(1<<1)
+#define HM_ADMA_INT		(1<<2)
+#define HM_ADMA_ACT_TRAN	(2<<4)
+#define HM_ADMA_LEN(x)		((x)<<16)
+
 #define ELFIN_CFCON_BASE	0x4B800000
 
 #define ATA_MUX			(ELFIN_CFCON_BASE+0x1800)
@@ -1098,6 +1152,13 @@ static inline S3C24X0_SPI * S3C24X0_GetBase_SPI(void)
 /* watchdog */
 #define WTCON_OFFSET		0x00
 
+/* PWM timers */
+#define TCFG0_OFFSET		0x00
+#define TCFG1_OFFSET		0x04
+#define TCON_OFFSET		0x08
+#define TCNTB0_OFFSET		0x0c
+#define TCNTO0_OFFSET		0x14
+
 /* LCD controller */
 #define LCDBGCON_OFFSET		0x5c
 
@@ -189,6 +189,7 @@ typedef struct {
 	S3C24X0_REG8	res2[3];
 #endif
 	S3C24X0_REG32	UBRDIV;
+	S3C24X0_REG32	UDIVSLOT;	/* S3C2450 fractional divider */
 } /*__attribute__((__packed__))*/ S3C24X0_UART;
 
 
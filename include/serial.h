@@ -1,7 +1,13 @@
 #ifndef __SERIAL_H__
 #define __SERIAL_H__
 
+#include <stddef.h>
+
 void serial_putc(const char c);
 void serial_puts(const char *s);
+void serial_write(const char *buf, size_t len);
+void serial_poll(void);
+void serial_flush(void);
+int serial_setbrg(unsigned int baud);
 
 #endif /*__SERIAL_H__*/
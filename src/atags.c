@@ -86,6 +86,17 @@ static void setup_cmdline_atag(const char * line)
     params = atag_next(params);              /* move pointer to next tag */
 }
 
+static void setup_bootlog_atag(unsigned int start, size_t size)
+{
+    params->hdr.tag = ATAG_BOOTLOG;         /* RAM log tag */
+    params->hdr.size = atag_size(atag_bootlog);  /* size tag */
+
+    params->u.bootlog.start = start;        /* physical start, header first */
+    params->u.bootlog.size = size;          /* size including the header */
+
+    params = atag_next(params);              /* move pointer to next tag */
+}
+
 static void setup_end_atag(void)
 {
     params->hdr.tag = ATAG_NONE;            /* Empty tag ends list */
@@ -95,13 +106,21 @@ static void setup_end_atag(void)
 void setup_atags(void *parameters)
 {
     setup_core_atag(parameters, 4096);
+#ifdef CONFIG_LOG
+    /* keep the kernel off the log */
+    setup_mem_atag(PHYS_SDRAM_1, PHYS_SDRAM_1_SIZE - CFG_LOG_SIZE);
+#else
     setup_mem_atag(PHYS_SDRAM_1, PHYS_SDRAM_1_SIZE);
+#endif
     if (config.device == DEVICE_MINI2451) {
         setup_mem_atag(PHYS_SDRAM_2, PHYS_SDRAM_2_SIZE);
     }
-    if (strlen(config.initramfs)) {
+    if (config.initramfs_size) {
         setup_initrd2_atag(config.initramfs_address, config.initramfs_size);
     }
     setup_cmdline_atag(config.cmdline);
+#ifdef CONFIG_LOG
+    setup_bootlog_atag(CFG_LOG_BASE, CFG_LOG_SIZE);
+#endif
     setup_end_atag();
 }
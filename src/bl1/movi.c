@@ -24,7 +24,29 @@
 #include "config.h"
 #include "movi.h"
 
+/* blocks read up front, enough to cover the image header in start.S */
+#define MOVI_BL2_HDR_BLKCNT 2
+
+extern u32 _image_size;
+
+/*
+ * Copy the header blocks first, then only as much of the rest as the image
+ * size recorded there asks for.  The iROM helper moves blocks in pairs.
+ */
 void movi_bl2_copy(void)
 {
-    CopyMovitoMem(MOVI_BL2_POS, MOVI_BL2_BLKCNT, (u32 *)CFG_NANOBOOT_BASE, MOVI_INIT_REQUIRED);
+    u32 blkcnt;
+
+    CopyMovitoMem(MOVI_BL2_POS, MOVI_BL2_HDR_BLKCNT, (u32 *)CFG_NANOBOOT_BASE, MOVI_INIT_REQUIRED);
+
+    blkcnt = (_image_size + MOVI_BLKSIZE - 1) / MOVI_BLKSIZE;
+    blkcnt = (blkcnt + 1) & ~1;
+    if (blkcnt < MOVI_BL2_HDR_BLKCNT || blkcnt > MOVI_BL2_BLKCNT) {
+        blkcnt = MOVI_BL2_BLKCNT;
+    }
+
+    if (blkcnt > MOVI_BL2_HDR_BLKCNT) {
+        CopyMovitoMem(MOVI_BL2_POS + MOVI_BL2_HDR_BLKCNT, blkcnt - MOVI_BL2_HDR_BLKCNT,
+                      (u32 *)(CFG_NANOBOOT_BASE + MOVI_BL2_HDR_BLKCNT * MOVI_BLKSIZE), 0);
+    }
 }
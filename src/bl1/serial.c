@@ -18,28 +18,128 @@
  *
  */
 
+#include <string.h>
 #include "s3c2450.h"
+#include "clock.h"
+#include "serial.h"
+
+#define UFSTAT_TX_FULL      (1 << 14)
+#define UTRSTAT_TX_EMPTY    (1 << 2)
 
 /*
- * Output a single byte to the serial port.
+ * Output is queued in a ring buffer and moved into the 64 byte tx FIFO
+ * whenever there is room, so callers only wait on the UART when the ring
+ * itself is full.  serial_poll() is also called while waiting on the card,
+ * letting console output drain during disk transfers.
  */
-void serial_putc(const char c)
+#define SERIAL_RING_SIZE    4096    /* power of two */
+
+static char ring[SERIAL_RING_SIZE];
+static unsigned int ring_head, ring_tail;
+
+/*
+ * Move queued bytes into the tx FIFO until it is full or the ring is empty.
+ */
+void serial_poll(void)
 {
     S3C24X0_UART *const uart = S3C24X0_GetBase_UART(S3C24X0_UART0);
 
-    /* wait for room in the tx FIFO */
-    while (!(uart->UTRSTAT & 0x2));
+    while (ring_tail != ring_head && !(uart->UFSTAT & UFSTAT_TX_FULL)) {
+        uart->UTXH = ring[ring_tail++ & (SERIAL_RING_SIZE - 1)];
+    }
+}
+
+static void serial_queue(char c)
+{
+    while (ring_head - ring_tail == SERIAL_RING_SIZE) {
+        serial_poll();
+    }
+
+    ring[ring_head++ & (SERIAL_RING_SIZE - 1)] = c;
+}
 
-    uart->UTXH = c;
+/*
+ * Output a single byte to the serial port.
+ */
+void serial_putc(const char c)
+{
+    serial_queue(c);
 
     /* If \n, also do \r */
     if (c == '\n')
-        serial_putc('\r');
+        serial_queue('\r');
+
+    serial_poll();
+}
+
+/*
+ * Queue a run of bytes and start them on their way.  This is where \n gets
+ * its \r, so callers hand over plain text.
+ */
+void serial_write(const char *buf, size_t len)
+{
+    while (len--) {
+        serial_queue(*buf);
+        if (*buf++ == '\n') {
+            serial_queue('\r');
+        }
+    }
+
+    serial_poll();
 }
 
 void serial_puts(const char *s)
 {
-    while (*s) {
-        serial_putc(*s++);
+    serial_write(s, strlen(s));
+}
+
+/*
+ * Wait until everything queued has left the transmitter.
+ */
+void serial_flush(void)
+{
+    S3C24X0_UART *const uart = S3C24X0_GetBase_UART(S3C24X0_UART0);
+
+    while (ring_tail != ring_head) {
+        serial_poll();
     }
+
+    while (!(uart->UTRSTAT & UTRSTAT_TX_EMPTY));
+}
+
+/*
+ * UDIVSLOT patterns, indexed by the number of 1/16 bit periods that have to
+ * be added to UBRDIV to get the requested rate (see manual chapter 11).
+ */
+static const unsigned short udivslot[16] = {
+    0x0000, 0x0080, 0x0808, 0x0888, 0x2222, 0x4924, 0x4a52, 0x54aa,
+    0x5555, 0xd555, 0xd5d5, 0xddd5, 0xdddd, 0xdfdd, 0xdfdf, 0xffdf,
+};
+
+/*
+ * Switch the console to a new baud rate, derived from the current PCLK.
+ * Anything still queued is sent at the old rate first.  Returns -1 if the
+ * rate can't be reached.
+ */
+int serial_setbrg(unsigned int baud)
+{
+    S3C24X0_UART *const uart = S3C24X0_GetBase_UART(S3C24X0_UART0);
+    unsigned int div;
+
+    if (baud == 0) {
+        return -1;
+    }
+
+    /* PCLK / baud in 1/16ths of UBRDIV + 1, rounded to nearest */
+    div = (clock_get_pclk() + baud / 2) / baud;
+    if (div < 16 || (div >> 4) - 1 > 0xffff) {
+        return -1;
+    }
+
+    serial_flush();
+
+    uart->UBRDIV = (div >> 4) - 1;
+    uart->UDIVSLOT = udivslot[div & 15];
+
+    return 0;
 }
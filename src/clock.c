@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <asm/types.h>
+#include "s3c2450.h"
+#include "config.h"
+
+/*
+ * Clock rates are read back from the clock controller rather than derived
+ * from config.h, so they stay correct whatever lowlevel_init programmed.
+ */
+
+/* Fout = m * Fin / (p * 2^s) */
+static unsigned int pll_rate(unsigned int m, unsigned int p, unsigned int s)
+{
+    return (u64)m * CONFIG_SYS_CLK_FREQ / (p << s);
+}
+
+unsigned int clock_get_mpll(void)
+{
+    u32 con = MPLLCON_REG;
+
+    return pll_rate((con >> 14) & 0x3ff, (con >> 5) & 0x3f, con & 0x7);
+}
+
+/* MSYSCLK runs from the MPLL once lowlevel_init has switched it over */
+static unsigned int clock_get_msysclk(void)
+{
+    if (!(CLKSRCCON_REG & (1 << 4))) {
+        return CONFIG_SYS_CLK_FREQ;
+    }
+
+    return clock_get_mpll();
+}
+
+unsigned int clock_get_armclk(void)
+{
+    return clock_get_msysclk() / (((CLKDIV0CON_REG >> 9) & 0xf) + 1);
+}
+
+unsigned int clock_get_hclk(void)
+{
+    u32 div = CLKDIV0CON_REG;
+
+    return clock_get_msysclk() / (((div >> 4) & 0x3) + 1) / ((div & 0x3) + 1);
+}
+
+unsigned int clock_get_pclk(void)
+{
+    return clock_get_hclk() / (((CLKDIV0CON_REG >> 2) & 0x1) + 1);
+}
+
+unsigned int clock_get_epll(void)
+{
+    u32 con = EPLLCON_REG;
+
+    return pll_rate((con >> 16) & 0xff, (con >> 8) & 0x3f, con & 0x7);
+}
+
+/* SCLK_HSMMC1, the EPLL derived base clock of the HSMMC1 controller */
+unsigned int clock_get_hsmmc(void)
+{
+    return clock_get_epll() / (((CLKDIV1CON_REG >> 6) & 0x3) + 1);
+}
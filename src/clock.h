@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __CLOCK_H
+#define __CLOCK_H
+
+unsigned int clock_get_mpll(void);
+unsigned int clock_get_armclk(void);
+unsigned int clock_get_hclk(void);
+unsigned int clock_get_pclk(void);
+unsigned int clock_get_epll(void);
+unsigned int clock_get_hsmmc(void);
+
+#endif /* __CLOCK_H */
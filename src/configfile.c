@@ -29,19 +29,66 @@ const char CMDLINE_DEFAULT[] = "console=ttySAC0,115200 root=/dev/mmcblk0p2 "
                                "rootfstype=ext4 rootwait";
 const TCHAR KERNEL_DEFAULT[] = _T("zImage");
 const TCHAR INITRAMFS_DEFAULT[] = _T("");
+const TCHAR DTB_DEFAULT[] = _T("");
 
 config_t config;
 
+/* whether cmdline was set, and what was appended to it, for images */
+static bool cmdline_given;
+static char cmdline_appended[sizeof(config.cmdline)];
+
 static void cmdline_set(char *s, int lineno)
 {
     strncpy(config.cmdline, s, sizeof(config.cmdline));
     config.cmdline[sizeof(config.cmdline) - 1] = '\0';
+    cmdline_given = true;
+}
+
+/* append s to the string in buf, returning false if it had to be cut short */
+static bool cmdline_cat(char *buf, size_t size, const char *s)
+{
+    size_t room = size - strlen(buf) - 1;
+
+    strncat(buf, s, room);
+    return strlen(s) <= room;
 }
 
 static void cmdline_append(char *s, int lineno)
 {
-    strncat(config.cmdline, " ", sizeof(config.cmdline));
-    strncat(config.cmdline, s, sizeof(config.cmdline));
+    if (!cmdline_cat(config.cmdline, sizeof(config.cmdline), " ")
+            || !cmdline_cat(config.cmdline, sizeof(config.cmdline), s)
+            || !cmdline_cat(cmdline_appended, sizeof(cmdline_appended), " ")
+            || !cmdline_cat(cmdline_appended, sizeof(cmdline_appended), s)) {
+        panic("config error on line %d: \"cmdline\" is too long\n", lineno);
+    }
+}
+
+static void baudrate_set(char *s, int lineno)
+{
+    unsigned int baud = strtoul(s, NULL, 0);
+    if (baud < 1200 || baud > 3000000) {
+        panic("config error on line %d: \"baudrate\" must be between 1200 "
+              "and 3000000\n", lineno);
+    }
+
+    config.baudrate = baud;
+}
+
+static void image_set(char *s, int lineno)
+{
+    strncpy(config.image, s, sizeof(config.image));
+    config.image[sizeof(config.image) - 1] = '\0';
+}
+
+static void kernel_hz_set(char *s, int lineno)
+{
+    unsigned int hz = strtoul(s, NULL, 0);
+    if (hz != 0 && (hz < 10 || hz > 10000)) {
+        panic("config error on line %d: \"kernel_hz\" must be 0 or between "
+              "10 and 10000\n", lineno);
+    }
+
+    config.kernel_hz = hz;
 }
 
 static void kernel_set(char *s, int lineno)
@@ -67,6 +114,62 @@ static void kernel_address_set(char *s, int lineno)
     config.kernel_address = addr;
 }
 
+/*
+ * Parse exactly 2 * len hex digits into len bytes, most significant first.
+ */
+static bool parse_hex(const char *s, unsigned char *out, size_t len)
+{
+    int hi, lo;
+
+    while (len--) {
+        if (!isxdigit(s[0]) || !isxdigit(s[1])) {
+            return false;
+        }
+        hi = isdigit(s[0]) ? s[0] - '0' : tolower(s[0]) - 'a' + 10;
+        lo = isdigit(s[1]) ? s[1] - '0' : tolower(s[1]) - 'a' + 10;
+        *out++ = hi << 4 | lo;
+        s += 2;
+    }
+
+    return *s == '\0';
+}
+
+static void crc32_set(digest_t *digest, const char *name, char *s, int lineno)
+{
+    unsigned char b[4];
+
+    if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+        s += 2;
+    }
+    if (!parse_hex(s, b, sizeof(b))) {
+        panic("config error on line %d: \"%s\" must be 8 hex digits\n",
+              lineno, name);
+    }
+
+    digest->crc32 = b[0] << 24 | b[1] << 16 | b[2] << 8 | b[3];
+    digest->crc32_set = true;
+}
+
+static void sha256_set(digest_t *digest, const char *name, char *s, int lineno)
+{
+    if (!parse_hex(s, digest->sha256, sizeof(digest->sha256))) {
+        panic("config error on line %d: \"%s\" must be 64 hex digits\n",
+              lineno, name);
+    }
+
+    digest->sha256_set = true;
+}
+
+static void kernel_crc32_set(char *s, int lineno)
+{
+    crc32_set(&config.kernel_digest, "kernel_crc32", s, lineno);
+}
+
+static void kernel_sha256_set(char *s, int lineno)
+{
+    sha256_set(&config.kernel_digest, "kernel_sha256", s, lineno);
+}
+
 static void initramfs_set(char *s, int lineno)
 {
     strncpy(config.initramfs, s, sizeof(config.initramfs));
@@ -76,6 +179,13 @@ static void initramfs_set(char *s, int lineno)
 static void initramfs_address_set(char *s, int lineno)
 {
     unsigned int addr = strtoul(s, NULL, 0);
+
+    /* bank 2 is only there on the Mini2451, that is checked when loading */
+    if (addr >= PHYS_SDRAM_2 && addr < PHYS_SDRAM_2 + PHYS_SDRAM_2_SIZE) {
+        config.initramfs_address = addr;
+        return;
+    }
+
     if ((addr < PHYS_SDRAM_1 + 0x8000)
         || (addr >= PHYS_SDRAM_1 + PHYS_SDRAM_1_SIZE)) {
         panic("config error on line %d: \"initramfs_address\" is outside of "
@@ -90,6 +200,52 @@ static void initramfs_address_set(char *s, int lineno)
     config.initramfs_address = addr;
 }
 
+static void initramfs_crc32_set(char *s, int lineno)
+{
+    crc32_set(&config.initramfs_digest, "initramfs_crc32", s, lineno);
+}
+
+static void initramfs_sha256_set(char *s, int lineno)
+{
+    sha256_set(&config.initramfs_digest, "initramfs_sha256", s, lineno);
+}
+
+static void dtb_set(char *s, int lineno)
+{
+    strncpy(config.dtb, s, sizeof(config.dtb));
+    config.dtb[sizeof(config.dtb) - 1] = '\0';
+}
+
+static void dtb_address_set(char *s, int lineno)
+{
+    unsigned int addr = strtoul(s, NULL, 0);
+
+    /* the kernel wants it 64-bit aligned */
+    if (addr & 7) {
+        panic("config error on line %d: \"dtb_address\" must be a multiple "
+              "of 8\n", lineno);
+    }
+
+    /* bank 2 is only there on the Mini2451, that is checked when loading */
+    if (addr >= PHYS_SDRAM_2 && addr < PHYS_SDRAM_2 + PHYS_SDRAM_2_SIZE) {
+        config.dtb_address = addr;
+        return;
+    }
+
+    if ((addr < PHYS_SDRAM_1 + 0x8000)
+        || (addr >= PHYS_SDRAM_1 + PHYS_SDRAM_1_SIZE)) {
+        panic("config error on line %d: \"dtb_address\" is outside of "
+              "SDRAM range\n", lineno);
+    }
+
+    if (addr >= PHYS_SDRAM_1 + PHYS_SDRAM_1_SIZE - CFG_NANOBOOT_SIZE) {
+        panic("config error on line %d: \"dtb_address\" is within "
+              "nanoboot's reserved memory", lineno);
+    }
+
+    config.dtb_address = addr;
+}
+
 static void mini2451(char *s, int lineno)
 {
     config.device = DEVICE_MINI2451;
@@ -105,6 +261,78 @@ static void quiet(char *s, int lineno)
     config.quiet = true;
 }
 
+static void extent_cache(char *s, int lineno)
+{
+    config.extent_cache = true;
+}
+
+static void auto_address(char *s, int lineno)
+{
+    config.auto_address = true;
+}
+
+static void boot_timing(char *s, int lineno)
+{
+    config.boot_timing = true;
+}
+
+/* the kernel command line option starting with opt, or NULL */
+static char *cmdline_find(const char *opt)
+{
+    size_t len = strlen(opt);
+    char *p = config.cmdline;
+
+    while (*p) {
+        if (strncmp(p, opt, len) == 0
+                && (p == config.cmdline || *(p - 1) == ' ')) {
+            return p;
+        }
+        p++;
+    }
+
+    return NULL;
+}
+
+/*
+ * Make the kernel console follow a changed baud rate: the rate of an existing
+ * console=ttySAC0 option is replaced, or one is appended if there is none.
+ */
+static void cmdline_set_console(unsigned int baud)
+{
+    static const char console[] = "console=ttySAC0";
+    char rest[sizeof(config.cmdline)];
+    char opt[sizeof(console) + 12];     /* " ", console, "," and baud */
+    char *p, *q;
+
+    p = cmdline_find(console);
+    if (!p) {
+        snprintf(opt, sizeof(opt), "%s%s,%u", config.cmdline[0] ? " " : "",
+                 console, baud);
+        if (!cmdline_cat(config.cmdline, sizeof(config.cmdline), opt)) {
+            panic("kernel command line is too long\n");
+        }
+        return;
+    }
+
+    /* keep any parity/bits suffix, e.g. 115200n8 */
+    p += sizeof(console) - 1;
+    q = p;
+    if (*q == ',') {
+        q++;
+        while (isdigit(*q)) {
+            q++;
+        }
+    }
+
+    strcpy(rest, q);
+    *p = '\0';
+    snprintf(opt, sizeof(opt), ",%u", baud);
+    if (!cmdline_cat(config.cmdline, sizeof(config.cmdline), opt)
+            || !cmdline_cat(config.cmdline, sizeof(config.cmdline), rest)) {
+        panic("kernel command line is too long\n");
+    }
+}
+
 typedef struct {
     const char *name;
     void (*set)(char *s, int lineno);
@@ -112,11 +340,20 @@ typedef struct {
 } property_t;
 
 static const property_t properties[] = {
+    {"baudrate",          baudrate_set,          NULL          },
     {"cmdline",           cmdline_set,           cmdline_append},
+    {"dtb",               dtb_set,               NULL          },
+    {"dtb_address",       dtb_address_set,       NULL          },
+    {"image",             image_set,             NULL          },
     {"kernel",            kernel_set,            NULL          },
     {"kernel_address",    kernel_address_set,    NULL          },
+    {"kernel_hz",         kernel_hz_set,         NULL          },
+    {"kernel_crc32",      kernel_crc32_set,      NULL          },
+    {"kernel_sha256",     kernel_sha256_set,     NULL          },
     {"initramfs",         initramfs_set,         NULL          },
     {"initramfs_address", initramfs_address_set, NULL          },
+    {"initramfs_crc32",   initramfs_crc32_set,   NULL          },
+    {"initramfs_sha256",  initramfs_sha256_set,  NULL          },
     {NULL},
 };
 
@@ -126,9 +363,12 @@ typedef struct {
 } directive_t;
 
 static const directive_t directives[] = {
-    {"mini2451", mini2451},
-    {"nanopi",   nanopi  },
-    {"quiet",    quiet   },
+    {"auto_address", auto_address},
+    {"boot_timing",  boot_timing },
+    {"extent_cache", extent_cache},
+    {"mini2451",     mini2451    },
+    {"nanopi",       nanopi      },
+    {"quiet",        quiet       },
     {NULL},
 };
 
@@ -240,11 +480,23 @@ void read_configfile(void)
 
     config.device = DEVICE_NANOPI;
     config.quiet = false;
+    config.extent_cache = false;
+    config.boot_timing = false;
+    config.auto_address = false;
+    config.baudrate = 0;
+    config.kernel_hz = 200;
     strcpy(config.cmdline, CMDLINE_DEFAULT);
+    cmdline_given = false;
+    cmdline_appended[0] = '\0';
+    config.image[0] = '\0';
     strcpy(config.kernel, KERNEL_DEFAULT);
     config.kernel_address = PHYS_SDRAM_1 + 0x8000;
+    memset(&config.kernel_digest, 0, sizeof(config.kernel_digest));
     strcpy(config.initramfs, INITRAMFS_DEFAULT);
     config.initramfs_address = PHYS_SDRAM_1 + 0x3000000;
+    memset(&config.initramfs_digest, 0, sizeof(config.initramfs_digest));
+    strcpy(config.dtb, DTB_DEFAULT);
+    config.dtb_address = PHYS_SDRAM_1 + 0x2f00000;
 
     fr = f_open(&f, "nanoboot.txt", FA_READ);
     if (fr == FR_OK) {
@@ -254,4 +506,52 @@ void read_configfile(void)
 
         f_close(&f);
     }
+
+    if (config.baudrate) {
+        cmdline_set_console(config.baudrate);
+    }
+}
+
+/*
+ * Use s, the command line from an image, in place of the default.  One set
+ * in nanoboot.txt wins; anything appended there and the baudrate still apply.
+ */
+void config_set_cmdline(const char *s)
+{
+    if (cmdline_given) {
+        return;
+    }
+
+    config.cmdline[0] = '\0';
+    if (!cmdline_cat(config.cmdline, sizeof(config.cmdline), s)
+            || !cmdline_cat(config.cmdline, sizeof(config.cmdline),
+                            cmdline_appended)) {
+        panic("kernel command line is too long\n");
+    }
+
+    if (config.baudrate) {
+        cmdline_set_console(config.baudrate);
+    }
+}
+
+/* whether the kernel command line has an option starting with opt */
+bool config_cmdline_has(const char *opt)
+{
+    return cmdline_find(opt) != NULL;
+}
+
+/* add an option to the end of the kernel command line, if it fits whole */
+void config_cmdline_append(const char *s)
+{
+    size_t len = strlen(config.cmdline);
+
+    if ((len ? 1 : 0) + strlen(s) >= sizeof(config.cmdline) - len) {
+        printf("kernel command line is full, not adding %s\n", s);
+        return;
+    }
+
+    if (len) {
+        strcat(config.cmdline, " ");
+    }
+    strcat(config.cmdline, s);
 }
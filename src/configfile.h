@@ -27,19 +27,42 @@ typedef enum {
     DEVICE_MINI2451,
 } device_t;
 
+/* expected checksums of an image, each only checked if set */
+typedef struct {
+    bool crc32_set;
+    unsigned int crc32;
+    bool sha256_set;
+    unsigned char sha256[32];
+} digest_t;
+
 typedef struct {
     device_t device;
     bool quiet;
+    bool extent_cache;
+    bool boot_timing;
+    bool auto_address;
+    unsigned int baudrate;
+    unsigned int kernel_hz;
     char cmdline[1024];
+    TCHAR image[256];
     TCHAR kernel[256];
     unsigned int kernel_address;
+    size_t kernel_size;
+    digest_t kernel_digest;
     TCHAR initramfs[256];
     unsigned int initramfs_address;
     size_t initramfs_size;
+    digest_t initramfs_digest;
+    TCHAR dtb[256];
+    unsigned int dtb_address;
+    size_t dtb_size;
 } config_t;
 
 extern config_t config;
 
 void read_configfile(void);
+void config_set_cmdline(const char *s);
+bool config_cmdline_has(const char *opt);
+void config_cmdline_append(const char *s);
 
 #endif /*__CONFIGFILE_H__*/
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * CRC-32 (IEEE 802.3, as used by gzip and zlib)
+ *
+ * Slice-by-8: eight bytes are folded in per step with eight table lookups
+ * instead of eight dependent shifts, which keeps up with the card.  The 8 KB
+ * of tables are built on first use rather than carried in the image.
+ */
+
+#include <asm/types.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "crc32.h"
+
+#define CRC32_POLY  0xedb88320
+
+static u32 table[8][256];
+static bool table_ready;
+
+static void crc32_init(void)
+{
+    u32 c;
+    int n, k;
+
+    for (n = 0; n < 256; n++) {
+        c = n;
+        for (k = 0; k < 8; k++) {
+            c = c & 1 ? (c >> 1) ^ CRC32_POLY : c >> 1;
+        }
+        table[0][n] = c;
+    }
+
+    for (n = 0; n < 256; n++) {
+        c = table[0][n];
+        for (k = 1; k < 8; k++) {
+            c = (c >> 8) ^ table[0][c & 0xff];
+            table[k][n] = c;
+        }
+    }
+
+    table_ready = true;
+}
+
+u32 crc32(u32 crc, const void *buf, size_t len)
+{
+    const u8 *p = buf;
+    const u32 *w;
+    u32 one, two;
+
+    if (!table_ready) {
+        crc32_init();
+    }
+
+    crc = ~crc;
+
+    while (len && ((u32)p & 3)) {
+        crc = (crc >> 8) ^ table[0][(crc ^ *p++) & 0xff];
+        len--;
+    }
+
+    /* little endian only, as is everything nanoboot runs on */
+    w = (const u32 *)p;
+    while (len >= 8) {
+        one = *w++ ^ crc;
+        two = *w++;
+        crc = table[7][one & 0xff] ^ table[6][(one >> 8) & 0xff]
+            ^ table[5][(one >> 16) & 0xff] ^ table[4][one >> 24]
+            ^ table[3][two & 0xff] ^ table[2][(two >> 8) & 0xff]
+            ^ table[1][(two >> 16) & 0xff] ^ table[0][two >> 24];
+        len -= 8;
+    }
+    p = (const u8 *)w;
+
+    while (len--) {
+        crc = (crc >> 8) ^ table[0][(crc ^ *p++) & 0xff];
+    }
+
+    return ~crc;
+}
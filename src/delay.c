@@ -15,7 +15,19 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <asm/types.h>
 #include "s3c2450.h"
+#include "clock.h"
+#include "delay.h"
+
+/* timer 4 counts at PCLK / (32 + 1) / 2 once delay_init() has run */
+#define DELAY_TIMER_DIV     (33 * 2)
+
+/* cycles the ARM926 takes per pass of the kernel's delay loop */
+#define LOOP_CYCLES         4
+
+/* the loop is timed for this fraction of a second, well within 16 bits */
+#define MEASURE_HZ          200
 
 void delay_init(void)
 {
@@ -42,3 +54,44 @@ void delay_ms(unsigned int ms)
     }
     delay_us(ms * 1000);
 }
+
+/* the kernel's __delay() on ARMv5, subs and bhi, kept in one cache line */
+static void __attribute__((noinline)) delay_loop(u32 loops)
+{
+    __asm__ __volatile__(
+        "       .balign 8\n"
+        "1:     subs    %0, %0, #1\n"
+        "       bhi     1b\n"
+        : "+r" (loops) : : "cc");
+}
+
+/*
+ * Time the kernel's delay loop against timer 4 and return loops_per_jiffy
+ * for a kernel with the given HZ, or 0 if the timer ran out.
+ */
+unsigned int delay_lpj(unsigned int hz)
+{
+    u32 loops = clock_get_armclk() / LOOP_CYCLES / MEASURE_HZ;
+    u32 start, end;
+
+    delay_init();
+    TCNTB4_REG = 0xffff;
+    TCON_REG = (TCON_REG & ~(TCON_4_AUTO | TCON_4_ONOFF)) | TCON_4_UPDATE;
+    TCON_REG = (TCON_REG & ~TCON_4_UPDATE) | TCON_4_ONOFF;
+    while (TCNTO4_REG == 0);
+
+    /* once to get the loop into the I-cache */
+    delay_loop(1);
+
+    start = TCNTO4_REG;
+    delay_loop(loops);
+    end = TCNTO4_REG;
+    TCON_REG &= ~TCON_4_ONOFF;
+
+    if (end == 0 || end >= start) {
+        return 0;
+    }
+
+    return (u64)loops * clock_get_pclk()
+        / ((u64)(start - end) * DELAY_TIMER_DIV * hz);
+}
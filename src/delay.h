@@ -21,5 +21,6 @@
 void delay_init(void);
 void delay_us(unsigned short us);
 void delay_ms(unsigned int ms);
+unsigned int delay_lpj(unsigned int hz);
 
 #endif /* __DELAY_H */
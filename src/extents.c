@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Extent manifest
+ *
+ * The ENV blocks between BL2 and BL1 hold, for each image, the runs of
+ * sectors the file occupied the last time it was loaded, keyed by its
+ * start cluster, size and modification time.  When the directory entry
+ * found by f_open() still matches the key the image is read straight from
+ * those runs and the FAT is never touched.  Otherwise the image is loaded
+ * through FatFs as usual and its slot is rewritten before the kernel is
+ * started.
+ */
+
+#include <asm/types.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "fatfs/diskio.h"
+#include "config.h"
+#include "extents.h"
+#include "hsmmc.h"
+#include "movi.h"
+
+#ifdef CONFIG_EXTENTS
+
+#define EXTENTS_MAGIC       0x5458454e  /* "NEXT" */
+
+#define EXTENTS_SLOT_BLKCNT (MOVI_ENV_BLKCNT / EXTENTS_SLOTS)
+#define EXTENTS_SLOT_MAX    ((EXTENTS_SLOT_BLKCNT * MOVI_BLKSIZE - 32) \
+                             / sizeof(FEXTENT))
+
+struct extents_slot {
+    u32 magic;
+    u32 sclust;
+    u32 size;
+    u32 stamp;
+    u32 count;
+    u32 csum;
+    u32 reserved[2];
+    FEXTENT ext[EXTENTS_SLOT_MAX];
+};
+
+static struct extents_slot manifest[EXTENTS_SLOTS];
+static bool dirty[EXTENTS_SLOTS];
+
+static u32 extents_csum(const struct extents_slot *s)
+{
+    const u32 *p = (const u32 *)s->ext;
+    u32 csum = s->magic + s->sclust + s->size + s->stamp + s->count;
+    unsigned int i;
+
+    for (i = 0; i < s->count * 2; i++) {
+        csum += *p++;
+    }
+
+    return ~csum;
+}
+
+static bool extents_valid(const struct extents_slot *s)
+{
+    DWORD nsect = 0;
+    unsigned int i;
+
+    if (s->magic != EXTENTS_MAGIC || s->count > EXTENTS_SLOT_MAX
+            || s->csum != extents_csum(s)) {
+        return false;
+    }
+
+    for (i = 0; i < s->count; i++) {
+        nsect += s->ext[i].nsect;
+    }
+
+    return nsect == (s->size + MOVI_BLKSIZE - 1) / MOVI_BLKSIZE;
+}
+
+static u32 env_pos(int slot)
+{
+    return MOVI_BL2_POS + MOVI_BL2_BLKCNT + slot * EXTENTS_SLOT_BLKCNT;
+}
+
+/* read the manifest from the ENV blocks */
+void extents_init(void)
+{
+    if (disk_read(0, (BYTE *)manifest, env_pos(0),
+                  EXTENTS_SLOTS * EXTENTS_SLOT_BLKCNT) != RES_OK) {
+        memset(manifest, 0, sizeof(manifest));
+    }
+}
+
+/*
+ * Read the image open in f to dest using the extents recorded in slot.
+ * Returns 0 when the image was loaded, or -ENOENT if the slot does not
+ * describe this file and it has to be read through FatFs instead.
+ */
+int extents_load(int slot, FIL *f, void *dest)
+{
+    static u32 tail[MOVI_BLKSIZE / 4];
+    const struct extents_slot *s = &manifest[slot];
+    BYTE *p = dest;
+    DWORD left = f->fsize / MOVI_BLKSIZE;
+    DWORD n;
+    unsigned int i;
+
+    if (!extents_valid(s) || s->sclust != f->sclust || s->size != f->fsize
+            || s->stamp != f->fstamp) {
+        return -ENOENT;
+    }
+
+    for (i = 0; i < s->count; i++) {
+        n = s->ext[i].nsect;
+        if (n > left) {
+            n = left;
+        }
+
+        if (n && disk_read(0, p, s->ext[i].sect, n) != RES_OK) {
+            return -EIO;
+        }
+        p += n * MOVI_BLKSIZE;
+        left -= n;
+
+        /* the partial last sector must not spill past the image */
+        if (n < s->ext[i].nsect) {
+            if (disk_read(0, (BYTE *)tail, s->ext[i].sect + n, 1) != RES_OK) {
+                return -EIO;
+            }
+            memcpy(p, tail, f->fsize % MOVI_BLKSIZE);
+            break;
+        }
+    }
+
+    return 0;
+}
+
+/* remember where the image open in f lives, if it is not already known */
+void extents_record(int slot, FIL *f)
+{
+    struct extents_slot *s = &manifest[slot];
+    bool valid = extents_valid(s);
+    UINT count;
+
+    if (valid && s->sclust == f->sclust && s->size == f->fsize
+            && s->stamp == f->fstamp) {
+        return;
+    }
+
+    memset(s, 0, sizeof(*s));
+
+    if (f_extents(f, s->ext, EXTENTS_SLOT_MAX, &count) != FR_OK) {
+        /*
+         * Too fragmented to describe, leave the slot empty.  One that held
+         * nothing usable already needn't be written again every boot.
+         */
+        memset(s->ext, 0, sizeof(s->ext));
+        if (valid) {
+            dirty[slot] = true;
+        }
+        return;
+    }
+
+    dirty[slot] = true;
+    s->magic = EXTENTS_MAGIC;
+    s->sclust = f->sclust;
+    s->size = f->fsize;
+    s->stamp = f->fstamp;
+    s->count = count;
+    s->csum = extents_csum(s);
+}
+
+/* write back the slots that changed since extents_init() */
+void extents_commit(void)
+{
+    int slot;
+
+    for (slot = 0; slot < EXTENTS_SLOTS; slot++) {
+        if (!dirty[slot]) {
+            continue;
+        }
+
+        if (hsmmc_write_blocks(env_pos(slot), EXTENTS_SLOT_BLKCNT,
+                               (const u32 *)&manifest[slot])) {
+            printf("extent manifest write failed\n");
+        }
+        dirty[slot] = false;
+    }
+}
+
+#else
+
+void extents_init(void)
+{
+}
+
+int extents_load(int slot, FIL *f, void *dest)
+{
+    return -ENOENT;
+}
+
+void extents_record(int slot, FIL *f)
+{
+}
+
+void extents_commit(void)
+{
+}
+
+#endif /* CONFIG_EXTENTS */
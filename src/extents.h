@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __EXTENTS_H
+#define __EXTENTS_H
+
+#include <stddef.h>
+#include "fatfs/ff.h"
+
+/* manifest slots, one per image nanoboot loads */
+enum {
+    EXTENTS_KERNEL = 0,
+    EXTENTS_INITRAMFS,
+    EXTENTS_SLOTS,
+};
+
+void extents_init(void);
+int extents_load(int slot, FIL *f, void *dest);
+void extents_record(int slot, FIL *f);
+void extents_commit(void);
+
+#endif /* __EXTENTS_H */
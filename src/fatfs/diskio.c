@@ -1,9 +1,17 @@
 #include "asm/types.h"
 #include "fatfs/diskio.h"
+#include "config.h"
+#include "hsmmc.h"
 #include "movi.h"
+#include "serial.h"
 #include "stdio.h"
 #include "string.h"
 
+/* number of blocks staged at a time for unaligned destinations */
+#define BOUNCE_BLKCNT   16
+
+static u32 bounce[BOUNCE_BLKCNT * 128];
+
 DSTATUS disk_status(BYTE pdrv)
 {
     if (pdrv != 0) {
@@ -19,32 +27,91 @@ DSTATUS disk_initialize(BYTE pdrv)
         return STA_NOINIT | STA_NODISK | STA_PROTECT;
     }
 
+#ifdef CONFIG_HSMMC
+    if (hsmmc_init() != 0) {
+        return STA_NOINIT | STA_PROTECT;
+    }
+#endif
+
     return STA_PROTECT;
 }
 
+#ifdef CONFIG_HSMMC
+static int read_blocks(DWORD sector, UINT count, u32 *buf)
+{
+    return hsmmc_read_blocks(sector, count, buf) == 0;
+}
+#else
+/*
+ * The iROM helper only moves an even number of blocks, so an odd trailing
+ * block is read as a pair into a buffer of its own and the wanted half is
+ * copied out.
+ */
+static int read_blocks(DWORD sector, UINT count, u32 *buf)
+{
+    static u32 tail[2 * 128];
+    UINT even = count & ~1;
+
+    /* the iROM helper blocks, top up the UART FIFO before it does */
+    serial_poll();
+
+    if (even && !CopyMovitoMem(sector, even, buf, 0)) {
+        return 0;
+    }
+
+    if (count & 1) {
+        if (!CopyMovitoMem(sector + even, 2, tail, 0)) {
+            return 0;
+        }
+        memcpy(buf + even * 128, tail, 512);
+    }
+
+    return 1;
+}
+#endif
+
+/*
+ * Word aligned destinations are read in place, in runs of at most
+ * MOVI_RW_MAXBLKS blocks.  Anything else is staged through the bounce
+ * buffer a few blocks at a time.  As a sector is a whole number of words,
+ * no sector of a misaligned destination is aligned either, so there is no
+ * aligned middle to read in place; the whole run is bounced.  Images are
+ * only ever loaded to word aligned addresses, so this path is rarely taken.
+ */
 DRESULT disk_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
 {
+    UINT n;
+
     if (pdrv != 0) {
         return RES_PARERR;
     }
 
-    int readcount = count;
-    if (count & 1) {
-        readcount += 1;
+    if (!((u32)buff & 3)) {
+        while (count) {
+            n = count > MOVI_RW_MAXBLKS ? MOVI_RW_MAXBLKS : count;
+            if (!read_blocks(sector, n, (u32 *)buff)) {
+                goto error;
+            }
+            buff += n * 512;
+            sector += n;
+            count -= n;
+        }
+        return RES_OK;
     }
 
-    if ((u32)buff & 3 || readcount > count) {
-        u32 tmp[readcount * 128];
-        if (!CopyMovitoMem(sector, readcount, tmp, 0)) {
-            printf("CopyMovitoMem error\n");
-            return RES_ERROR;
-        }
-        memcpy(buff, tmp, count * 512);
-    } else {
-        if (!CopyMovitoMem(sector, readcount, (u32 *)buff, 0)) {
-            return RES_ERROR;
+    while (count) {
+        n = count > BOUNCE_BLKCNT ? BOUNCE_BLKCNT : count;
+        if (!read_blocks(sector, n, bounce)) {
+            goto error;
         }
+        memcpy(buff, bounce, n * 512);
+        buff += n * 512;
+        sector += n;
+        count -= n;
     }
-
     return RES_OK;
+
+error:
+    printf("disk read error at sector %u\n", (unsigned int)sector);
+    return RES_ERROR;
 }
@@ -18,6 +18,7 @@
 
 #include "ff.h"			/* Declarations of FatFs API */
 #include "diskio.h"		/* Declarations of disk I/O functions */
+#include <string.h>		/* Block copy and fill of the C library */
 
 
 /*--------------------------------------------------------------------------
@@ -411,6 +412,16 @@ static BYTE CurrVol;			/* Current drive */
 static FILESEM Files[_FS_LOCK];	/* Open object lock semaphores */
 #endif
 
+#if _FAT_CACHE
+#if !_FS_READONLY
+#error _FAT_CACHE can only be used at read-only configuration
+#endif
+static DWORD FatCache[_FAT_CACHE * _MAX_SS / 4];	/* FAT sector cache (word aligned for DMA) */
+static FATFS *FatCacheFs;		/* File system object the cache belongs to (NULL:invalid) */
+static DWORD FatCacheSect;		/* First cached sector, relative to the FAT start */
+static UINT FatCacheCnt;		/* Number of cached sectors */
+#endif
+
 #if _USE_LFN == 0			/* Non LFN feature */
 #define	DEFINE_NAMEBUF		BYTE sfn[12]
 #define INIT_BUF(dobj)		(dobj).fn = sfn
@@ -460,27 +471,13 @@ static const BYTE ExCvt[] = _EXCVT;	/* Upper conversion table for extended chara
 /* Copy memory to memory */
 static
 void mem_cpy (void* dst, const void* src, UINT cnt) {
-	BYTE *d = (BYTE*)dst;
-	const BYTE *s = (const BYTE*)src;
-
-#if _WORD_ACCESS == 1
-	while (cnt >= sizeof (int)) {
-		*(int*)d = *(int*)s;
-		d += sizeof (int); s += sizeof (int);
-		cnt -= sizeof (int);
-	}
-#endif
-	while (cnt--)
-		*d++ = *s++;
+	memcpy(dst, src, cnt);
 }
 
 /* Fill memory */
 static
 void mem_set (void* dst, int val, UINT cnt) {
-	BYTE *d = (BYTE*)dst;
-
-	while (cnt--)
-		*d++ = (BYTE)val;
+	memset(dst, val, cnt);
 }
 
 /* Compare memory to memory */
@@ -768,6 +765,29 @@ DWORD clust2sect (	/* !=0: Sector number, 0: Failed - invalid cluster# */
 /*-----------------------------------------------------------------------*/
 /* FAT access - Read value of a FAT entry                                */
 /*-----------------------------------------------------------------------*/
+
+#if _FAT_CACHE
+static
+BYTE* fat_byte (	/* Pointer to the byte in the FAT cache, 0:Disk error */
+	FATFS* fs,	/* File system object */
+	DWORD bc	/* Byte offset in the FAT */
+)
+{
+	DWORD sect = bc / SS(fs);
+	UINT n;
+
+
+	if (FatCacheFs != fs || sect < FatCacheSect || sect >= FatCacheSect + FatCacheCnt) {
+		n = fs->fsize - sect < _FAT_CACHE ? (UINT)(fs->fsize - sect) : _FAT_CACHE;	/* Load the FAT onwards from the sector */
+		FatCacheFs = 0;
+		if (disk_read(fs->drv, (BYTE*)FatCache, fs->fatbase + sect, n) != RES_OK)
+			return 0;
+		FatCacheFs = fs; FatCacheSect = sect; FatCacheCnt = n;
+	}
+	return (BYTE*)FatCache + (bc - FatCacheSect * SS(fs));
+}
+#endif
+
 /* Hidden API for hacks and disk tools */
 
 DWORD get_fat (	/* 0xFFFFFFFF:Disk error, 1:Internal error, 2..0x0FFFFFFF:Cluster status */
@@ -787,6 +807,26 @@ DWORD get_fat (	/* 0xFFFFFFFF:Disk error, 1:Internal error, 2..0x0FFFFFFF:Cluste
 		val = 0xFFFFFFFF;	/* Default value falls on disk error */
 
 		switch (fs->fs_type) {
+#if _FAT_CACHE
+		case FS_FAT12 :
+			bc = (UINT)clst; bc += bc / 2;
+			if ((p = fat_byte(fs, bc++)) == 0) break;
+			wc = *p;
+			if ((p = fat_byte(fs, bc)) == 0) break;	/* The entry may straddle two sectors */
+			wc |= *p << 8;
+			val = clst & 1 ? wc >> 4 : (wc & 0xFFF);
+			break;
+
+		case FS_FAT16 :
+			if ((p = fat_byte(fs, clst * 2)) == 0) break;
+			val = LD_WORD(p);
+			break;
+
+		case FS_FAT32 :
+			if ((p = fat_byte(fs, clst * 4)) == 0) break;
+			val = LD_DWORD(p) & 0x0FFFFFFF;
+			break;
+#else
 		case FS_FAT12 :
 			bc = (UINT)clst; bc += bc / 2;
 			if (move_window(fs, fs->fatbase + (bc / SS(fs))) != FR_OK) break;
@@ -807,6 +847,7 @@ DWORD get_fat (	/* 0xFFFFFFFF:Disk error, 1:Internal error, 2..0x0FFFFFFF:Cluste
 			p = &fs->win[clst * 4 % SS(fs)];
 			val = LD_DWORD(p) & 0x0FFFFFFF;
 			break;
+#endif
 
 		default:
 			val = 1;	/* Internal error */
@@ -2193,6 +2234,9 @@ FRESULT find_volume (	/* FR_OK(0): successful, !=0: any error occurred */
 	/* Following code attempts to mount the volume. (analyze BPB and initialize the fs object) */
 
 	fs->fs_type = 0;					/* Clear the file system object */
+#if _FAT_CACHE
+	FatCacheFs = 0;						/* Invalidate the FAT cache */
+#endif
 	fs->drv = LD2PD(vol);				/* Bind the logical drive and a physical drive */
 	stat = disk_initialize(fs->drv);	/* Initialize the physical drive */
 	if (stat & STA_NOINIT)				/* Check if the initialization succeeded */
@@ -2518,6 +2562,9 @@ FRESULT f_open (
 			fp->err = 0;						/* Clear error flag */
 			fp->sclust = ld_clust(dj.fs, dir);	/* File start cluster */
 			fp->fsize = LD_DWORD(dir + DIR_FileSize);	/* File size */
+#if _USE_EXTENTS
+			fp->fstamp = LD_DWORD(dir + DIR_WrtTime);	/* Modified time and date */
+#endif
 			fp->fptr = 0;						/* File pointer */
 			fp->dsect = 0;
 #if _USE_FASTSEEK
@@ -2547,7 +2594,7 @@ FRESULT f_read (
 {
 	FRESULT res;
 	DWORD clst, sect, remain;
-	UINT rcnt, cc;
+	UINT rcnt, cc, run;
 	BYTE csect, *rbuff = (BYTE*)buff;
 
 
@@ -2586,8 +2633,17 @@ FRESULT f_read (
 			sect += csect;
 			cc = btr / SS(fp->fs);				/* When remaining bytes >= sector size, */
 			if (cc) {							/* Read maximum contiguous sectors directly */
-				if (csect + cc > fp->fs->csize)	/* Clip at cluster boundary */
-					cc = fp->fs->csize - csect;
+				if (csect + cc > fp->fs->csize) {	/* Clip at the end of the contiguous run */
+					run = fp->fs->csize - csect;
+					while (run < cc && run + fp->fs->csize <= _MAX_RUN) {	/* Merge following clusters while they are consecutive */
+						clst = get_fat(fp->fs, fp->clust);
+						if (clst == 0xFFFFFFFF) ABORT(fp->fs, FR_DISK_ERR);
+						if (clst != fp->clust + 1) break;
+						fp->clust = clst;				/* Last cluster touched by this read */
+						run += fp->fs->csize;
+					}
+					if (cc > run) cc = run;
+				}
 				if (disk_read(fp->fs->drv, rbuff, sect, cc) != RES_OK)
 					ABORT(fp->fs, FR_DISK_ERR);
 #if !_FS_READONLY && _FS_MINIMIZE <= 2			/* Replace one of the read sectors with cached data if it contains a dirty sector */
@@ -4010,6 +4066,58 @@ FRESULT f_forward (
 
 
 
+#if _USE_EXTENTS
+/*-----------------------------------------------------------------------*/
+/* Get the sector extents occupied by a file                             */
+/*-----------------------------------------------------------------------*/
+
+FRESULT f_extents (
+	FIL* fp,		/* Pointer to the file object */
+	FEXTENT* ext,	/* Pointer to the extent array to fill */
+	UINT max,		/* Number of items in the extent array */
+	UINT* n			/* Pointer to number of extents stored */
+)
+{
+	FRESULT res;
+	DWORD clst, prev, remain, nsect;
+	UINT i = 0;
+
+
+	*n = 0;	/* Clear extent counter */
+
+	res = validate(fp);								/* Check validity of the object */
+	if (res != FR_OK) LEAVE_FF(fp->fs, res);
+	if (fp->err)									/* Check error */
+		LEAVE_FF(fp->fs, (FRESULT)fp->err);
+
+	remain = (fp->fsize + SS(fp->fs) - 1) / SS(fp->fs);	/* Sectors holding the file data */
+	clst = fp->sclust;
+	while (remain) {
+		if (clst < 2 || clst >= fp->fs->n_fatent) ABORT(fp->fs, FR_INT_ERR);
+		if (i == max) LEAVE_FF(fp->fs, FR_NOT_ENOUGH_CORE);
+		ext[i].sect = clust2sect(fp->fs, clst);
+		nsect = 0;
+		do {										/* Follow the chain while clusters are consecutive */
+			nsect += fp->fs->csize;
+			if (nsect >= remain) {
+				nsect = remain;
+				break;
+			}
+			prev = clst;
+			clst = get_fat(fp->fs, clst);
+			if (clst == 0xFFFFFFFF) ABORT(fp->fs, FR_DISK_ERR);
+		} while (clst == prev + 1);
+		ext[i++].nsect = nsect;
+		remain -= nsect;
+	}
+
+	*n = i;
+	LEAVE_FF(fp->fs, FR_OK);
+}
+#endif /* _USE_EXTENTS */
+
+
+
 #if _USE_MKFS && !_FS_READONLY
 /*-----------------------------------------------------------------------*/
 /* Create file system on the logical drive                               */
@@ -128,6 +128,9 @@ typedef struct {
 #if _USE_FASTSEEK
 	DWORD*	cltbl;			/* Pointer to the cluster link map table (Nulled on file open) */
 #endif
+#if _USE_EXTENTS
+	DWORD	fstamp;			/* Last modified date (upper 16 bits) and time (lower 16 bits) */
+#endif
 #if _FS_LOCK
 	UINT	lockid;			/* File lock ID origin from 1 (index of file semaphore table Files[]) */
 #endif
@@ -179,6 +182,15 @@ typedef struct {
 
 
 
+/* File extent structure (FEXTENT) */
+
+typedef struct {
+	DWORD	sect;			/* First sector of the extent */
+	DWORD	nsect;			/* Number of consecutive sectors */
+} FEXTENT;
+
+
+
 /* File function return code (FRESULT) */
 
 typedef enum {
@@ -214,6 +226,7 @@ FRESULT f_close (FIL* fp);											/* Close an open file object */
 FRESULT f_read (FIL* fp, void* buff, UINT btr, UINT* br);			/* Read data from a file */
 FRESULT f_write (FIL* fp, const void* buff, UINT btw, UINT* bw);	/* Write data to a file */
 FRESULT f_forward (FIL* fp, UINT(*func)(const BYTE*,UINT), UINT btf, UINT* bf);	/* Forward data to the stream */
+FRESULT f_extents (FIL* fp, FEXTENT* ext, UINT max, UINT* n);		/* Get the sector extents of a file */
 FRESULT f_lseek (FIL* fp, DWORD ofs);								/* Move file pointer of a file object */
 FRESULT f_truncate (FIL* fp);										/* Truncate file */
 FRESULT f_sync (FIL* fp);											/* Flush cached data of a writing file */
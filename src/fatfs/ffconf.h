@@ -23,7 +23,7 @@
 /  and optional writing functions as well. */
 
 
-#define _FS_MINIMIZE	3
+#define _FS_MINIMIZE	2
 /* This option defines minimization level to remove some basic API functions.
 /
 /   0: All basic functions are enabled.
@@ -55,6 +55,21 @@
 /* This option switches fast seek feature. (0:Disable or 1:Enable) */
 
 
+#include "movi.h"
+#define	_MAX_RUN		MOVI_RW_MAXBLKS
+/* This option sets the maximum number of sectors f_read() passes to a single
+/  disk_read() call when it merges consecutive clusters of a file into one
+/  transfer, which is what the disk driver moves per command. Set it to 0 to
+/  clip every direct read at the cluster boundary. */
+
+
+#define	_FAT_CACHE		256
+/* This option sets the number of FAT sectors held in a dedicated RAM cache.
+/  When it is not 0, get_fat() loads this many FAT sectors with a single
+/  disk_read() and resolves cluster chains from memory instead of the sector
+/  window. The cache is only valid at read-only configuration. (0:Disable) */
+
+
 #define _USE_LABEL		0
 /* This option switches volume label functions, f_getlabel() and f_setlabel().
 /  (0:Disable or 1:Enable) */
@@ -65,6 +80,12 @@
 /  To enable it, also _FS_TINY need to be set to 1. */
 
 
+#define	_USE_EXTENTS	1
+/* This option switches f_extents() function, which maps a file to runs of
+/  consecutive sectors, and the time stamp kept in the file object.
+/  (0:Disable or 1:Enable) */
+
+
 /*---------------------------------------------------------------------------/
 / Locale and Namespace Configurations
 /---------------------------------------------------------------------------*/
@@ -0,0 +1,515 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Flattened device tree fixup
+ *
+ * The device tree loaded with the kernel is patched where it lies with the
+ * memory banks, command line, initramfs and RAM log, the same things the
+ * ATAG list carries.  The structure block is walked once to find /memory
+ * and /chosen and the properties to replace.  The changes are then spliced
+ * in from the end backwards, moving only what follows each one, and new
+ * property names are added to the end of the strings block.  The blob grows
+ * into the room after it; nothing is unflattened or copied elsewhere.
+ *
+ * Only the usual dtc layout, with the strings block last, is handled.
+ */
+
+#include <asm/types.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+#include "config.h"
+#include "configfile.h"
+#include "fdt.h"
+
+#define FDT_MAGIC       0xd00dfeed
+#define FDT_VERSION     17
+
+/* structure block tokens */
+#define FDT_BEGIN_NODE  1
+#define FDT_END_NODE    2
+#define FDT_PROP        3
+#define FDT_NOP         4
+#define FDT_END         9
+
+/* all fields big endian */
+struct fdt_header {
+    u32 magic;
+    u32 totalsize;
+    u32 off_dt_struct;
+    u32 off_dt_strings;
+    u32 off_mem_rsvmap;
+    u32 version;
+    u32 last_comp_version;
+    u32 boot_cpuid_phys;
+    u32 size_dt_strings;
+    u32 size_dt_struct;
+};
+
+/* children of the root that are patched */
+enum {
+    NODE_MEMORY,
+    NODE_CHOSEN,
+    NODES,
+};
+
+struct fdt_node {
+    const char *name;
+    bool found;
+    bool props_open;    /* no subnode seen yet */
+    u32 props_end;      /* where new properties go */
+};
+
+struct fdt_set {
+    int node;
+    const char *name;
+    const void *val;    /* NULL to remove the property */
+    u32 len;
+    u32 off;            /* where the property is, if size */
+    u32 size;
+};
+
+/* a change to the structure block: old bytes at off replaced by new ones */
+struct fdt_splice {
+    u32 off;
+    u32 old;
+    const u8 *data;
+    u32 len;
+};
+
+#define MAX_SETS    6
+#define MAX_SPLICES (MAX_SETS + NODES)
+
+static struct fdt_node nodes[NODES];
+static struct fdt_set sets[MAX_SETS];
+static int nsets;
+
+static struct fdt_splice splices[MAX_SPLICES];
+static int nsplices;
+
+/* encoded properties and nodes, and names new to the strings block */
+static u8 scratch[FDT_GROW] __attribute__((aligned(4)));
+static u32 scratch_len;
+static char newstr[128];
+static u32 newstr_len;
+
+static inline u32 be32(u32 x)
+{
+    return (x >> 24) | ((x >> 8) & 0xff00) | ((x << 8) & 0xff0000)
+        | (x << 24);
+}
+
+static inline u32 align4(u32 x)
+{
+    return (x + 3) & ~3;
+}
+
+/* a node name matches with or without its unit address */
+static bool node_match(const char *name, const char *want)
+{
+    size_t len = strlen(want);
+
+    return strncmp(name, want, len) == 0
+        && (name[len] == '\0' || name[len] == '@');
+}
+
+static struct fdt_set *set_prop(int node, const char *name, const void *val,
+                                u32 len)
+{
+    struct fdt_set *set = &sets[nsets++];
+
+    set->node = node;
+    set->name = name;
+    set->val = val;
+    set->len = len;
+    set->size = 0;
+    return set;
+}
+
+/*
+ * One pass over the structure block, noting where each wanted node and
+ * property is and the root's cell sizes.  Returns the offset of the root's
+ * END_NODE, where new nodes go, or a negative error.
+ */
+static int fdt_walk(const u8 *dt, u32 size, const char *strings,
+                    u32 strings_size, u32 *acells, u32 *scells)
+{
+    struct fdt_node *cur = NULL;
+    const char *name;
+    u32 off = 0, tok, len, nameoff;
+    int depth = 0, root_end = -EINVAL;
+    int i;
+
+    while (off + 4 <= size) {
+        tok = be32(*(const u32 *)(dt + off));
+
+        switch (tok) {
+        case FDT_BEGIN_NODE:
+            name = (const char *)dt + off + 4;
+            for (len = 0; off + 4 + len < size && name[len]; len++) {
+            }
+            depth++;
+            if (depth == 3 && cur) {
+                cur->props_open = false;
+            }
+            off = align4(off + 4 + len + 1);
+            if (depth == 2) {
+                for (i = 0; i < NODES; i++) {
+                    if (!nodes[i].found && node_match(name, nodes[i].name)) {
+                        cur = &nodes[i];
+                        cur->found = true;
+                        cur->props_open = true;
+                        cur->props_end = off;
+                        break;
+                    }
+                }
+            }
+            break;
+
+        case FDT_PROP:
+            if (off + 12 > size) {
+                return -EINVAL;
+            }
+            len = be32(*(const u32 *)(dt + off + 4));
+            nameoff = be32(*(const u32 *)(dt + off + 8));
+            if (len > size - off - 12 || nameoff >= strings_size) {
+                return -EINVAL;
+            }
+            name = strings + nameoff;
+
+            if (depth == 1 && len == 4) {
+                if (strcmp(name, "#address-cells") == 0) {
+                    *acells = be32(*(const u32 *)(dt + off + 12));
+                } else if (strcmp(name, "#size-cells") == 0) {
+                    *scells = be32(*(const u32 *)(dt + off + 12));
+                }
+            }
+
+            if (depth == 2 && cur) {
+                for (i = 0; i < nsets; i++) {
+                    if (&nodes[sets[i].node] == cur
+                            && strcmp(name, sets[i].name) == 0) {
+                        sets[i].off = off;
+                        sets[i].size = 12 + align4(len);
+                    }
+                }
+            }
+
+            off += 12 + align4(len);
+            if (depth == 2 && cur && cur->props_open) {
+                cur->props_end = off;
+            }
+            break;
+
+        case FDT_END_NODE:
+            if (depth == 2) {
+                cur = NULL;
+            } else if (depth == 1) {
+                root_end = off;
+            }
+            depth--;
+            off += 4;
+            break;
+
+        case FDT_NOP:
+            off += 4;
+            break;
+
+        case FDT_END:
+            return root_end;
+
+        default:
+            return -EINVAL;
+        }
+    }
+
+    return -EINVAL;
+}
+
+/*
+ * Offset of name in the strings block, adding it to the new strings if it
+ * isn't there yet.
+ */
+static int string_offset(const char *strings, u32 strings_size,
+                         const char *name)
+{
+    size_t len = strlen(name) + 1;
+    u32 off;
+
+    for (off = 0; off + len <= strings_size; off++) {
+        if (memcmp(strings + off, name, len) == 0) {
+            return off;
+        }
+    }
+
+    for (off = 0; off < newstr_len; off += strlen(newstr + off) + 1) {
+        if (strcmp(newstr + off, name) == 0) {
+            return strings_size + off;
+        }
+    }
+
+    if (newstr_len + len > sizeof(newstr)) {
+        return -ENOSPC;
+    }
+    memcpy(newstr + newstr_len, name, len);
+    newstr_len += len;
+    return strings_size + newstr_len - len;
+}
+
+/* append a structure block token with len bytes of data to scratch */
+static int emit(u32 tok, const void *data, u32 len)
+{
+    u32 *p = (u32 *)(scratch + scratch_len);
+
+    if (scratch_len + 4 + align4(len) > sizeof(scratch)) {
+        return -ENOSPC;
+    }
+
+    *p = be32(tok);
+    memset((u8 *)(p + 1) + len, 0, align4(len) - len);
+    memcpy(p + 1, data, len);
+    scratch_len += 4 + align4(len);
+    return 0;
+}
+
+static int emit_prop(const struct fdt_set *set, const char *strings,
+                     u32 strings_size)
+{
+    int nameoff = string_offset(strings, strings_size, set->name);
+    u32 hdr[2];
+    u32 *p;
+    int ret;
+
+    if (nameoff < 0) {
+        return nameoff;
+    }
+
+    /* FDT_PROP, then len and nameoff, then the value */
+    hdr[0] = be32(set->len);
+    hdr[1] = be32(nameoff);
+    ret = emit(FDT_PROP, hdr, sizeof(hdr));
+    if (ret) {
+        return ret;
+    }
+    if (scratch_len + align4(set->len) > sizeof(scratch)) {
+        return -ENOSPC;
+    }
+    p = (u32 *)(scratch + scratch_len);
+    memset((u8 *)p + set->len, 0, align4(set->len) - set->len);
+    memcpy(p, set->val, set->len);
+    scratch_len += align4(set->len);
+    return 0;
+}
+
+static void splice(u32 off, u32 old, const u8 *data, u32 len)
+{
+    struct fdt_splice *sp = &splices[nsplices++];
+
+    sp->off = off;
+    sp->old = old;
+    sp->data = data;
+    sp->len = len;
+}
+
+/* store an address or size as the given number of big endian cells */
+static u32 *put_cells(u32 *p, u32 cells, u32 val)
+{
+    while (cells-- > 1) {
+        *p++ = 0;
+    }
+    *p++ = be32(val);
+    return p;
+}
+
+int setup_fdt(void *fdt, size_t room)
+{
+    struct fdt_header *hdr = fdt;
+    u8 *blob = fdt;
+    u8 *dt;
+    const char *strings;
+    u32 off_struct, size_struct, off_strings, size_strings, end;
+    u32 acells = 2, scells = 1;
+    u32 reg[8], *r;
+    u32 initrd_start, initrd_end;
+    u32 start;
+    struct fdt_set *reg_set;
+#ifdef CONFIG_LOG
+    u32 bootlog[4];
+    struct fdt_set *bootlog_set;
+#endif
+    struct fdt_splice tmp;
+    int root_end, ret;
+    int i, j, n;
+
+    if (be32(hdr->magic) != FDT_MAGIC || be32(hdr->version) < FDT_VERSION
+            || be32(hdr->last_comp_version) > FDT_VERSION) {
+        return -EINVAL;
+    }
+
+    off_struct = be32(hdr->off_dt_struct);
+    size_struct = be32(hdr->size_dt_struct);
+    off_strings = be32(hdr->off_dt_strings);
+    size_strings = be32(hdr->size_dt_strings);
+    end = off_strings + size_strings;
+    if (off_struct + size_struct > off_strings || end > room
+            || end > be32(hdr->totalsize)) {
+        return -EINVAL;
+    }
+    dt = blob + off_struct;
+    strings = (const char *)blob + off_strings;
+
+    nodes[NODE_MEMORY].name = "memory";
+    nodes[NODE_CHOSEN].name = "chosen";
+    for (n = 0; n < NODES; n++) {
+        nodes[n].found = false;
+    }
+    nsets = 0;
+    nsplices = 0;
+    scratch_len = 0;
+    newstr_len = 0;
+
+    set_prop(NODE_MEMORY, "device_type", "memory", sizeof("memory"));
+    reg_set = set_prop(NODE_MEMORY, "reg", reg, 0);
+    set_prop(NODE_CHOSEN, "bootargs", config.cmdline,
+             strlen(config.cmdline) + 1);
+    initrd_start = be32(config.initramfs_address);
+    initrd_end = be32(config.initramfs_address + config.initramfs_size);
+    if (config.initramfs_size) {
+        set_prop(NODE_CHOSEN, "linux,initrd-start", &initrd_start, 4);
+        set_prop(NODE_CHOSEN, "linux,initrd-end", &initrd_end, 4);
+    } else {
+        /* drop any left in the blob by whoever built it */
+        set_prop(NODE_CHOSEN, "linux,initrd-start", NULL, 0);
+        set_prop(NODE_CHOSEN, "linux,initrd-end", NULL, 0);
+    }
+#ifdef CONFIG_LOG
+    bootlog_set = set_prop(NODE_CHOSEN, "nanoboot,bootlog", bootlog, 0);
+#endif
+
+    root_end = fdt_walk(dt, size_struct, strings, size_strings, &acells,
+                        &scells);
+    if (root_end < 0) {
+        return root_end;
+    }
+    if (acells < 1 || acells > 2 || scells < 1 || scells > 2) {
+        return -EINVAL;
+    }
+
+    /* the memory banks, in the root's cell sizes */
+    r = reg;
+#ifdef CONFIG_LOG
+    /* keep the kernel off the log */
+    r = put_cells(r, acells, PHYS_SDRAM_1);
+    r = put_cells(r, scells, PHYS_SDRAM_1_SIZE - CFG_LOG_SIZE);
+#else
+    r = put_cells(r, acells, PHYS_SDRAM_1);
+    r = put_cells(r, scells, PHYS_SDRAM_1_SIZE);
+#endif
+    if (config.device == DEVICE_MINI2451) {
+        r = put_cells(r, acells, PHYS_SDRAM_2);
+        r = put_cells(r, scells, PHYS_SDRAM_2_SIZE);
+    }
+    reg_set->len = (r - reg) * 4;
+
+#ifdef CONFIG_LOG
+    /* the log's start and size, as ATAG_BOOTLOG gives them */
+    r = put_cells(bootlog, acells, CFG_LOG_BASE);
+    r = put_cells(r, scells, CFG_LOG_SIZE);
+    bootlog_set->len = (r - bootlog) * 4;
+#endif
+
+    /* properties of nodes that are there are replaced, removed or added */
+    for (i = 0; i < nsets; i++) {
+        struct fdt_set *set = &sets[i];
+        struct fdt_node *node = &nodes[set->node];
+
+        if (!node->found || (!set->val && !set->size)) {
+            continue;
+        }
+        start = scratch_len;
+        if (set->val) {
+            ret = emit_prop(set, strings, size_strings);
+            if (ret) {
+                return ret;
+            }
+        }
+        if (set->size) {
+            splice(set->off, set->size, scratch + start, scratch_len - start);
+        } else {
+            splice(node->props_end, 0, scratch + start, scratch_len - start);
+        }
+    }
+
+    /* and missing nodes are added to the end of the root */
+    for (n = 0; n < NODES; n++) {
+        if (nodes[n].found) {
+            continue;
+        }
+        start = scratch_len;
+        ret = emit(FDT_BEGIN_NODE, nodes[n].name, strlen(nodes[n].name) + 1);
+        for (i = 0; !ret && i < nsets; i++) {
+            if (sets[i].node == n && sets[i].val) {
+                ret = emit_prop(&sets[i], strings, size_strings);
+            }
+        }
+        if (!ret) {
+            ret = emit(FDT_END_NODE, NULL, 0);
+        }
+        if (ret) {
+            return ret;
+        }
+        splice(root_end, 0, scratch + start, scratch_len - start);
+    }
+
+    /* apply from the end backwards, so earlier offsets stay put */
+    for (i = 1; i < nsplices; i++) {
+        for (j = i; j > 0 && splices[j - 1].off < splices[j].off; j--) {
+            tmp = splices[j];
+            splices[j] = splices[j - 1];
+            splices[j - 1] = tmp;
+        }
+    }
+
+    for (i = 0; i < nsplices; i++) {
+        struct fdt_splice *sp = &splices[i];
+        u8 *at = dt + sp->off;
+
+        if (end + sp->len - sp->old + newstr_len > room) {
+            return -ENOSPC;
+        }
+        memmove(at + sp->len, at + sp->old, end - (off_struct + sp->off)
+                - sp->old);
+        memcpy(at, sp->data, sp->len);
+        end += sp->len - sp->old;
+        size_struct += sp->len - sp->old;
+        off_strings += sp->len - sp->old;
+    }
+
+    if (end + newstr_len > room) {
+        return -ENOSPC;
+    }
+    memcpy(blob + end, newstr, newstr_len);
+    size_strings += newstr_len;
+    end += newstr_len;
+
+    hdr->totalsize = be32(end);
+    hdr->off_dt_strings = be32(off_strings);
+    hdr->size_dt_strings = be32(size_strings);
+    hdr->size_dt_struct = be32(size_struct);
+    return 0;
+}
@@ -0,0 +1,601 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * gzip decompression
+ *
+ * An inflate for gzip members, decoding straight to the final place in
+ * memory like the LZ4 decoder.  Since the output is flat, back references
+ * are copied from what has already been written and no 32 KB window is
+ * kept.  Huffman codes up to FAST_BITS long are decoded with a single table
+ * lookup, longer ones a bit at a time from the canonical code counts.  The
+ * CRC in the trailer is not checked, the length is.
+ */
+
+#include <asm/types.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+#include "gunzip.h"
+
+#define GZIP_ID1            0x1f
+#define GZIP_ID2            0x8b
+#define GZIP_CM_DEFLATE     8
+
+/* header flags */
+#define FHCRC               0x02
+#define FEXTRA              0x04
+#define FNAME               0x08
+#define FCOMMENT            0x10
+#define FRESERVED           0xe0
+
+#define MAXBITS             15
+#define MAXLCODES           286
+#define MAXDCODES           30
+#define MAXCODES            (MAXLCODES + MAXDCODES)
+#define FIXLCODES           288
+
+#define FAST_BITS           9
+#define FAST_LEN_SHIFT      9   /* table entries are len << 9 | symbol */
+
+struct huffman {
+    u16 fast[1 << FAST_BITS];
+    u16 count[MAXBITS + 1];
+    u16 symbol[FIXLCODES];
+};
+
+struct inflate {
+    struct stream *s;
+    u32 bitbuf;
+    int bitcnt;
+    u8 *start;
+    u8 *p;
+    u8 *end;
+};
+
+/* tables for dynamic blocks, and the fixed code built once */
+static struct huffman lencode, distcode;
+static struct huffman fixlen, fixdist;
+
+static const u16 len_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+static const u8 len_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+static const u16 dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+    8193, 12289, 16385, 24577,
+};
+static const u8 dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+
+/* order code length code lengths are sent in */
+static const u8 clen_order[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15,
+};
+
+static int gunzip_fail(struct stream *s)
+{
+    return s->error ? s->error : -EINVAL;
+}
+
+/*
+ * Top up the bit buffer to at least n bits, as far as the input goes.
+ */
+static void fill(struct inflate *st, int n)
+{
+    int c;
+
+    while (st->bitcnt < n) {
+        c = stream_getc(st->s);
+        if (c < 0) {
+            return;
+        }
+        st->bitbuf |= (u32)c << st->bitcnt;
+        st->bitcnt += 8;
+    }
+}
+
+static int bits(struct inflate *st, int n, u32 *v)
+{
+    fill(st, n);
+    if (st->bitcnt < n) {
+        return gunzip_fail(st->s);
+    }
+
+    *v = st->bitbuf & ((1 << n) - 1);
+    st->bitbuf >>= n;
+    st->bitcnt -= n;
+    return 0;
+}
+
+/*
+ * Whole bytes, once the bit buffer has been brought to a byte boundary.
+ * Bytes the bit buffer has already taken from the input come first.
+ */
+static int getbyte(struct inflate *st)
+{
+    int c;
+
+    if (st->bitcnt >= 8) {
+        c = st->bitbuf & 0xff;
+        st->bitbuf >>= 8;
+        st->bitcnt -= 8;
+        return c;
+    }
+
+    c = stream_getc(st->s);
+    return c < 0 ? gunzip_fail(st->s) : c;
+}
+
+static int construct(struct huffman *h, const u8 *length, int n)
+{
+    u16 offs[MAXBITS + 1];
+    u16 next[MAXBITS + 1];
+    int sym, len, left, i;
+    u32 code, rev;
+
+    memset(h->count, 0, sizeof(h->count));
+    for (sym = 0; sym < n; sym++) {
+        h->count[length[sym]]++;
+    }
+
+    /* over-subscribed sets are no good, incomplete ones are allowed */
+    left = 1;
+    for (len = 1; len <= MAXBITS; len++) {
+        left <<= 1;
+        left -= h->count[len];
+        if (left < 0) {
+            return -EINVAL;
+        }
+    }
+
+    offs[1] = 0;
+    next[1] = 0;
+    for (len = 1; len < MAXBITS; len++) {
+        offs[len + 1] = offs[len] + h->count[len];
+        next[len + 1] = (next[len] + h->count[len]) << 1;
+    }
+
+    memset(h->fast, 0, sizeof(h->fast));
+    for (sym = 0; sym < n; sym++) {
+        len = length[sym];
+        if (!len) {
+            continue;
+        }
+
+        h->symbol[offs[len]++] = sym;
+
+        code = next[len]++;
+        if (len > FAST_BITS) {
+            continue;
+        }
+
+        /* codes are sent most significant bit first */
+        rev = 0;
+        for (i = 0; i < len; i++) {
+            rev = (rev << 1) | (code & 1);
+            code >>= 1;
+        }
+        for (i = rev; i < (1 << FAST_BITS); i += 1 << len) {
+            h->fast[i] = len << FAST_LEN_SHIFT | sym;
+        }
+    }
+
+    return 0;
+}
+
+static int decode(struct inflate *st, const struct huffman *h)
+{
+    int code = 0, first = 0, index = 0, count, len;
+    u16 e;
+
+    fill(st, FAST_BITS);
+    e = h->fast[st->bitbuf & ((1 << FAST_BITS) - 1)];
+    len = e >> FAST_LEN_SHIFT;
+    if (e && len <= st->bitcnt) {
+        st->bitbuf >>= len;
+        st->bitcnt -= len;
+        return e & ((1 << FAST_LEN_SHIFT) - 1);
+    }
+
+    for (len = 1; len <= MAXBITS; len++) {
+        fill(st, 1);
+        if (!st->bitcnt) {
+            return gunzip_fail(st->s);
+        }
+        code |= st->bitbuf & 1;
+        st->bitbuf >>= 1;
+        st->bitcnt--;
+
+        count = h->count[len];
+        if (code - count < first) {
+            return h->symbol[index + (code - first)];
+        }
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+
+    return -EINVAL;
+}
+
+static int codes(struct inflate *st, const struct huffman *lc,
+                 const struct huffman *dc)
+{
+    int sym;
+    u32 len, dist, v;
+    u8 *m;
+
+    for (;;) {
+        sym = decode(st, lc);
+        if (sym < 0) {
+            return sym;
+        }
+
+        if (sym < 256) {
+            if (st->p == st->end) {
+                return -ENOSPC;
+            }
+            *st->p++ = sym;
+            continue;
+        }
+
+        if (sym == 256) {
+            return 0;
+        }
+
+        sym -= 257;
+        if (sym >= 29 || bits(st, len_extra[sym], &v)) {
+            return gunzip_fail(st->s);
+        }
+        len = len_base[sym] + v;
+
+        sym = decode(st, dc);
+        if (sym < 0) {
+            return sym;
+        }
+        if (sym >= 30 || bits(st, dist_extra[sym], &v)) {
+            return gunzip_fail(st->s);
+        }
+        dist = dist_base[sym] + v;
+
+        if (dist > st->p - st->start) {
+            return -EINVAL;
+        }
+        if (len > st->end - st->p) {
+            return -ENOSPC;
+        }
+
+        /* most matches are short, memcpy() only pays off on long ones */
+        m = st->p - dist;
+        if (dist >= len && len >= 32) {
+            memcpy(st->p, m, len);
+            st->p += len;
+        } else {
+            while (len--) {
+                *st->p++ = *m++;
+            }
+        }
+    }
+}
+
+static int stored(struct inflate *st)
+{
+    u32 len;
+    int c, i, b[4];
+
+    st->bitbuf >>= st->bitcnt & 7;
+    st->bitcnt &= ~7;
+
+    for (i = 0; i < 4; i++) {
+        b[i] = getbyte(st);
+        if (b[i] < 0) {
+            return b[i];
+        }
+    }
+
+    len = b[0] | b[1] << 8;
+    if (len != (~(b[2] | b[3] << 8) & 0xffff)) {
+        return -EINVAL;
+    }
+    if (len > st->end - st->p) {
+        return -ENOSPC;
+    }
+
+    while (len && st->bitcnt) {
+        c = getbyte(st);
+        *st->p++ = c;
+        len--;
+    }
+
+    if (stream_read(st->s, st->p, len) != len) {
+        return gunzip_fail(st->s);
+    }
+    st->p += len;
+    return 0;
+}
+
+static int fixed(struct inflate *st)
+{
+    static bool built;
+    u8 length[FIXLCODES];
+    int sym;
+
+    if (!built) {
+        for (sym = 0; sym < 144; sym++) {
+            length[sym] = 8;
+        }
+        for (; sym < 256; sym++) {
+            length[sym] = 9;
+        }
+        for (; sym < 280; sym++) {
+            length[sym] = 7;
+        }
+        for (; sym < FIXLCODES; sym++) {
+            length[sym] = 8;
+        }
+        construct(&fixlen, length, FIXLCODES);
+
+        for (sym = 0; sym < MAXDCODES; sym++) {
+            length[sym] = 5;
+        }
+        construct(&fixdist, length, MAXDCODES);
+        built = true;
+    }
+
+    return codes(st, &fixlen, &fixdist);
+}
+
+static int dynamic(struct inflate *st)
+{
+    u8 length[MAXCODES];
+    u32 nlen, ndist, ncode, v, rep;
+    int index, sym, ret, len;
+
+    if (bits(st, 5, &nlen) || bits(st, 5, &ndist) || bits(st, 4, &ncode)) {
+        return gunzip_fail(st->s);
+    }
+    nlen += 257;
+    ndist += 1;
+    ncode += 4;
+    if (nlen > MAXLCODES || ndist > MAXDCODES) {
+        return -EINVAL;
+    }
+
+    memset(length, 0, 19);
+    for (index = 0; index < ncode; index++) {
+        if (bits(st, 3, &v)) {
+            return gunzip_fail(st->s);
+        }
+        length[clen_order[index]] = v;
+    }
+
+    /* the code length code lives in lencode until the real one is built */
+    ret = construct(&lencode, length, 19);
+    if (ret) {
+        return ret;
+    }
+
+    index = 0;
+    while (index < nlen + ndist) {
+        sym = decode(st, &lencode);
+        if (sym < 0) {
+            return sym;
+        }
+
+        if (sym < 16) {
+            length[index++] = sym;
+            continue;
+        }
+
+        len = 0;
+        if (sym == 16) {
+            if (index == 0) {
+                return -EINVAL;
+            }
+            len = length[index - 1];
+            ret = bits(st, 2, &rep);
+            rep += 3;
+        } else if (sym == 17) {
+            ret = bits(st, 3, &rep);
+            rep += 3;
+        } else {
+            ret = bits(st, 7, &rep);
+            rep += 11;
+        }
+        if (ret) {
+            return ret;
+        }
+        if (index + rep > nlen + ndist) {
+            return -EINVAL;
+        }
+        while (rep--) {
+            length[index++] = len;
+        }
+    }
+
+    /* no end of block code, no data */
+    if (length[256] == 0) {
+        return -EINVAL;
+    }
+
+    ret = construct(&lencode, length, nlen);
+    if (!ret) {
+        ret = construct(&distcode, length + nlen, ndist);
+    }
+    if (ret) {
+        return ret;
+    }
+
+    return codes(st, &lencode, &distcode);
+}
+
+static int inflate(struct inflate *st)
+{
+    u32 last, type;
+    int ret;
+
+    do {
+        if (bits(st, 1, &last) || bits(st, 2, &type)) {
+            return gunzip_fail(st->s);
+        }
+
+        switch (type) {
+        case 0:
+            ret = stored(st);
+            break;
+        case 1:
+            ret = fixed(st);
+            break;
+        case 2:
+            ret = dynamic(st);
+            break;
+        default:
+            ret = -EINVAL;
+            break;
+        }
+
+        if (ret) {
+            return ret;
+        }
+    } while (!last);
+
+    return 0;
+}
+
+static int skip_string(struct stream *s)
+{
+    int c;
+
+    do {
+        c = stream_getc(s);
+    } while (c > 0);
+
+    return c < 0 ? gunzip_fail(s) : 0;
+}
+
+static int gzip_header(struct stream *s)
+{
+    int flg, len, i, c;
+    u8 hdr[10];
+
+    if (stream_read(s, hdr, sizeof(hdr)) != sizeof(hdr)) {
+        return gunzip_fail(s);
+    }
+
+    flg = hdr[3];
+    if (hdr[0] != GZIP_ID1 || hdr[1] != GZIP_ID2 || hdr[2] != GZIP_CM_DEFLATE
+            || (flg & FRESERVED)) {
+        return -EINVAL;
+    }
+
+    if (flg & FEXTRA) {
+        len = 0;
+        for (i = 0; i < 16; i += 8) {
+            c = stream_getc(s);
+            if (c < 0) {
+                return gunzip_fail(s);
+            }
+            len |= c << i;
+        }
+        if (stream_read(s, NULL, len) != len) {
+            return gunzip_fail(s);
+        }
+    }
+
+    if ((flg & FNAME) && skip_string(s)) {
+        return gunzip_fail(s);
+    }
+    if ((flg & FCOMMENT) && skip_string(s)) {
+        return gunzip_fail(s);
+    }
+    if ((flg & FHCRC) && stream_read(s, NULL, 2) != 2) {
+        return gunzip_fail(s);
+    }
+
+    return 0;
+}
+
+bool gunzip_probe(const void *buf, size_t len)
+{
+    const u8 *p = buf;
+
+    return len >= 3 && p[0] == GZIP_ID1 && p[1] == GZIP_ID2
+           && p[2] == GZIP_CM_DEFLATE;
+}
+
+/*
+ * Decompress the gzip members s holds to out, writing no more than max
+ * bytes.  Anything after the last member that isn't another one, such as
+ * padding, is ignored.  Returns the decompressed size or a negative error.
+ */
+int gunzip_decode(struct stream *s, void *out, size_t max)
+{
+    struct inflate st = {
+        .s = s,
+        .start = out,
+        .p = out,
+        .end = (u8 *)out + max,
+    };
+    u8 *member;
+    u32 isize;
+    int ret, i, c;
+
+    do {
+        ret = gzip_header(s);
+        if (ret) {
+            return ret;
+        }
+
+        member = st.p;
+        st.bitbuf = 0;
+        st.bitcnt = 0;
+        ret = inflate(&st);
+        if (ret) {
+            return ret;
+        }
+
+        /* CRC32, then the length mod 2^32 */
+        st.bitbuf >>= st.bitcnt & 7;
+        st.bitcnt &= ~7;
+        isize = 0;
+        for (i = 0; i < 8; i++) {
+            c = getbyte(&st);
+            if (c < 0) {
+                return c;
+            }
+            isize = isize >> 8 | (u32)c << 24;
+        }
+        if (isize != (u32)(st.p - member)) {
+            return -EINVAL;
+        }
+    } while (!stream_eof(s) && *s->p == GZIP_ID1);
+
+    if (s->error) {
+        return s->error;
+    }
+
+    return st.p - st.start;
+}
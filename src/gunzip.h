@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __GUNZIP_H
+#define __GUNZIP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "stream.h"
+
+bool gunzip_probe(const void *buf, size_t len);
+int gunzip_decode(struct stream *s, void *out, size_t max);
+
+#endif /* __GUNZIP_H */
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Host simulation harness
+ *
+ * Runs the BL2 boot path against a card image: both SDRAM banks and the
+ * iROM variables below TCM_BASE are mapped at their physical addresses so
+ * the loader's address arithmetic is unchanged, and the jump to the kernel
+ * is replaced by a report of disk reads, sectors, bytes copied by memcpy and
+ * wall time for every boot phase the loader stamps.
+ */
+
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "config.h"
+#include "host.h"
+
+/* iROM variables live just below TCM_BASE, see movi.h */
+#define TCM_BASE            0x40004000
+#define TCM_MAP_BASE        0x40000000
+#define TCM_MAP_SIZE        0x8000
+
+#define PHASES_MAX          32
+
+struct stats {
+    unsigned long reads;
+    unsigned long sectors;
+    unsigned long long copied;
+};
+
+struct phase {
+    const char *name;
+    uint32_t us;
+    struct stats stats;
+};
+
+static struct stats stats;
+static struct phase phases[PHASES_MAX];
+static int nphases;
+
+int __real_disk_read(unsigned char pdrv, unsigned char *buff, uint32_t sector,
+                     unsigned int count);
+int __real_hsmmc_read_start(uint32_t start, uint32_t count, uint32_t *buf);
+void *__real_memcpy(void *dest, const void *src, size_t n);
+void __real_timer_stamp(const char *name, uint32_t ticks);
+
+void nanoboot_main(uint32_t lowlevel_raw, uint32_t copy_raw);
+
+int __wrap_disk_read(unsigned char pdrv, unsigned char *buff, uint32_t sector,
+                     unsigned int count)
+{
+    stats.reads++;
+    stats.sectors += count;
+    return __real_disk_read(pdrv, buff, sector, count);
+}
+
+int __wrap_hsmmc_read_start(uint32_t start, uint32_t count, uint32_t *buf)
+{
+    stats.reads++;
+    stats.sectors += count;
+    return __real_hsmmc_read_start(start, count, buf);
+}
+
+void *__wrap_memcpy(void *dest, const void *src, size_t n)
+{
+    stats.copied += n;
+    return __real_memcpy(dest, src, n);
+}
+
+void __wrap_timer_stamp(const char *name, uint32_t ticks)
+{
+    if (nphases < PHASES_MAX) {
+        phases[nphases].name = name;
+        phases[nphases].us = ticks;
+        phases[nphases].stats = stats;
+        nphases++;
+    }
+
+    __real_timer_stamp(name, ticks);
+}
+
+static void map_fixed(unsigned long base, unsigned long size)
+{
+    void *p = mmap((void *)base, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+    if (p != (void *)base) {
+        fprintf(stderr, "cannot map %#lx bytes at %#lx\n", size, base);
+        exit(1);
+    }
+}
+
+void host_boot(unsigned int entry, unsigned int params)
+{
+    struct stats prev = {0};
+    uint32_t prev_us = 0;
+    int i;
+
+    fprintf(stderr, "\n%-20s %10s %8s %10s %12s\n", "phase", "us",
+            "reads", "sectors", "copied");
+    for (i = 0; i < nphases; i++) {
+        fprintf(stderr, "%-20s %10u %8lu %10lu %12llu\n", phases[i].name,
+                phases[i].us - prev_us,
+                phases[i].stats.reads - prev.reads,
+                phases[i].stats.sectors - prev.sectors,
+                phases[i].stats.copied - prev.copied);
+        prev_us = phases[i].us;
+        prev = phases[i].stats;
+    }
+    fprintf(stderr, "%-20s %10u %8lu %10lu %12llu\n", "total", prev_us,
+            stats.reads, stats.sectors, stats.copied);
+    fprintf(stderr, "kernel entry %#x, parameters at %#x\n", entry, params);
+
+    exit(0);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int blkcnt;
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s CARD_IMAGE\n", argv[0]);
+        return 1;
+    }
+
+    if (host_disk_open(argv[1], &blkcnt)) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    map_fixed(PHYS_SDRAM_1, PHYS_SDRAM_1_SIZE);
+    map_fixed(PHYS_SDRAM_2, PHYS_SDRAM_2_SIZE);
+    map_fixed(TCM_MAP_BASE, TCM_MAP_SIZE);
+
+    /* what the iROM leaves behind: card size and block addressing */
+    *(volatile uint32_t *)(TCM_BASE - 0x4) = blkcnt;
+    *(volatile uint32_t *)(TCM_BASE - 0x8) = 1;
+
+    nanoboot_main(0xffff, 0xffff);
+    return 1;
+}
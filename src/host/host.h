@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __HOST_H
+#define __HOST_H
+
+/*
+ * Interface between the loader, built with CONFIG_HOST, and the host
+ * simulation harness.  Only plain C types are used here so the header can be
+ * included from both sides, one built against nanolib and the other against
+ * the host C library.
+ */
+
+/* block device stand-in backed by the card image */
+int host_disk_open(const char *path, unsigned int *blkcnt);
+
+/* replaces the jump to the kernel, reports and exits */
+void host_boot(unsigned int entry, unsigned int params);
+
+#endif /* __HOST_H */
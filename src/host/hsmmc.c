@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * HSMMC stand-in reading and writing a card image with pread/pwrite.  The
+ * split start/wait API completes the whole transfer in the start call.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "host.h"
+
+static int disk_fd = -1;
+static int pending;
+
+int host_disk_open(const char *path, unsigned int *blkcnt)
+{
+    struct stat st;
+
+    disk_fd = open(path, O_RDWR);
+    if (disk_fd < 0) {
+        disk_fd = open(path, O_RDONLY);
+    }
+    if (disk_fd < 0 || fstat(disk_fd, &st) < 0) {
+        return -errno;
+    }
+
+    *blkcnt = st.st_size / 512;
+    return 0;
+}
+
+int hsmmc_init(void)
+{
+    return disk_fd < 0 ? -ENODEV : 0;
+}
+
+int hsmmc_read_start(uint32_t start, uint32_t count, uint32_t *buf)
+{
+    size_t len = (size_t)count * 512;
+
+    if (pread(disk_fd, buf, len, (off_t)start * 512) != (ssize_t)len) {
+        return -EIO;
+    }
+
+    pending = 1;
+    return 0;
+}
+
+int hsmmc_read_wait(void)
+{
+    pending = 0;
+    return 0;
+}
+
+int hsmmc_read_blocks(uint32_t start, uint32_t count, uint32_t *buf)
+{
+    int ret = hsmmc_read_start(start, count, buf);
+
+    return ret ? ret : hsmmc_read_wait();
+}
+
+int hsmmc_write_blocks(uint32_t start, uint32_t count, const uint32_t *buf)
+{
+    size_t len = (size_t)count * 512;
+
+    if (pwrite(disk_fd, buf, len, (off_t)start * 512) != (ssize_t)len) {
+        return -EIO;
+    }
+
+    return 0;
+}
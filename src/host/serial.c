@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/* UART stand-in, console output goes to stdout */
+
+#include <string.h>
+#include <unistd.h>
+
+void serial_putc(const char c)
+{
+    if (write(1, &c, 1) < 0) {
+        _exit(1);
+    }
+}
+
+void serial_write(const char *buf, size_t len)
+{
+    if (write(1, buf, len) < 0) {
+        _exit(1);
+    }
+}
+
+void serial_puts(const char *s)
+{
+    serial_write(s, strlen(s));
+}
+
+void serial_poll(void)
+{
+}
+
+void serial_flush(void)
+{
+}
+
+int serial_setbrg(unsigned int baud)
+{
+    return 0;
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/* boot timer stand-in counting microseconds of wall time */
+
+#include <stdint.h>
+#include <time.h>
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint64_t start_us;
+
+static void __attribute__((constructor)) timer_start(void)
+{
+    start_us = now_us();
+}
+
+uint32_t timer_ticks(void)
+{
+    return now_us() - start_us;
+}
+
+/* the harness enters the loader at time zero */
+uint32_t timer_raw_ticks(uint32_t raw)
+{
+    return 0;
+}
+
+unsigned int timer_rate(void)
+{
+    return 1000000;
+}
+
+uint32_t timer_ticks_to_us(uint32_t ticks)
+{
+    return ticks;
+}
+
+/* what the delay loop measures on a 400 MHz ARM926, 4 cycles a pass */
+unsigned int delay_lpj(unsigned int hz)
+{
+    return 400000000 / 4 / hz;
+}
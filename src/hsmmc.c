@@ -0,0 +1,529 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Minimal driver for the HSMMC1 controller.  The iROM has already taken the
+ * card through identification and left it selected in the transfer state,
+ * so all that is done here is to claim the controller, bring the bus up to
+ * speed and issue reads.
+ */
+
+#include <asm/types.h>
+#include <errno.h>
+#include <stdbool.h>
+#include "s3c2450.h"
+#include "clock.h"
+#include "config.h"
+#include "movi.h"
+#include "mmu.h"
+#include "serial.h"
+#include "timer.h"
+#include "hsmmc.h"
+
+#define SD_SEND_RELATIVE_ADDR       3
+#define SD_SWITCH_FUNC              6
+#define MMC_SELECT_CARD             7
+#define MMC_SEND_EXT_CSD            8
+#define MMC_READ_MULTIPLE_BLOCK     18
+#define MMC_WRITE_MULTIPLE_BLOCK    25
+#define MMC_APP_CMD                 55
+#define SD_APP_SET_BUS_WIDTH        6
+
+/* CMDREG flags for each response type */
+#define RSP_NONE    HM_CMDREG_RSP_NONE
+#define RSP_R1      (HM_CMDREG_RSP_48 | HM_CMDREG_IDXCHK | HM_CMDREG_CRCCHK)
+#define RSP_R1B     (HM_CMDREG_RSP_48B | HM_CMDREG_IDXCHK | HM_CMDREG_CRCCHK)
+#define RSP_R6      RSP_R1
+
+/* card status bits in an R1 response that indicate a failed command */
+#define R1_ERRORS                   0xfff9a000
+
+/* number of status polls before a command is abandoned */
+#define HSMMC_TIMEOUT               0x1000000
+
+static bool high_capacity;
+static bool transfer_pending;
+
+static struct hsmmc_adma_desc adma_table[HSMMC_ADMA_DESCS];
+
+static void hsmmc_reset_lines(void)
+{
+    __REGb(HM_SWRST) = HM_SWRST_CMD | HM_SWRST_DAT;
+    while (__REGb(HM_SWRST) & (HM_SWRST_CMD | HM_SWRST_DAT));
+}
+
+static int hsmmc_wait_inhibit(void)
+{
+    unsigned int timeout = HSMMC_TIMEOUT;
+
+    while (__REG(HM_PRNSTS) & (HM_PRNSTS_CMDINHCMD | HM_PRNSTS_CMDINHDAT)) {
+        if (!--timeout) {
+            hsmmc_reset_lines();
+            return -ETIMEDOUT;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Poll for any of the interrupt status bits in mask.  A timeout of zero waits
+ * indefinitely, leaving it to the controller's data timeout to flag a card
+ * that has stopped responding.
+ */
+static int hsmmc_wait_int(u16 mask, unsigned int timeout)
+{
+    u16 status;
+
+    do {
+        /* let console output drain and the boot timer count its wraps */
+        serial_poll();
+        timer_ticks();
+
+        status = __REGw(HM_NORINTSTS);
+        if (status & HM_NORINT_ERR) {
+            __REGw(HM_ERRINTSTS) = __REGw(HM_ERRINTSTS);
+            __REGw(HM_NORINTSTS) = status;
+            hsmmc_reset_lines();
+            return -EIO;
+        }
+
+        if (status & mask) {
+            __REGw(HM_NORINTSTS) = status & mask;
+            return 0;
+        }
+    } while (!timeout || --timeout);
+
+    hsmmc_reset_lines();
+    return -ETIMEDOUT;
+}
+
+/*
+ * Issue a command and wait for its response.  For data commands the block
+ * size, block count and transfer mode must already be set up.
+ */
+static int hsmmc_cmd(u8 idx, u32 arg, u16 flags)
+{
+    int ret;
+
+    ret = hsmmc_wait_inhibit();
+    if (ret) {
+        return ret;
+    }
+
+    __REG(HM_ARGUMENT) = arg;
+    __REGw(HM_CMDREG) = HM_CMDREG_IDX(idx) | flags;
+
+    return hsmmc_wait_int(HM_NORINT_CMDCMPLT, HSMMC_TIMEOUT);
+}
+
+/* issue a command with an R1 or R1b response and check the card status */
+static int hsmmc_cmd_r1(u8 idx, u32 arg, u16 flags)
+{
+    int ret;
+
+    ret = hsmmc_cmd(idx, arg, flags);
+    if (ret) {
+        return ret;
+    }
+
+    if (__REG(HM_RSPREG0) & R1_ERRORS) {
+        hsmmc_reset_lines();
+        return -EIO;
+    }
+
+    return 0;
+}
+
+#ifdef CONFIG_HSMMC_HIGHSPEED
+/*
+ * Only an SD card is taken off the bus the iROM set up.  In the transfer
+ * state an MMC or eMMC answers CMD8 with its extended CSD, which is read and
+ * thrown away, while to an SD card it is an illegal command that goes
+ * unanswered.
+ */
+static bool hsmmc_is_sd(void)
+{
+    __REGw(HM_BLKSIZE) = 512;
+    __REGw(HM_BLKCNT) = 1;
+    __REGw(HM_TRNMOD) = HM_TRNMOD_READ;
+
+    if (hsmmc_cmd(MMC_SEND_EXT_CSD, 0, RSP_R1 | HM_CMDREG_DATA)) {
+        return true;
+    }
+
+    if (hsmmc_wait_int(HM_NORINT_BUFRDRDY, HSMMC_TIMEOUT) == 0) {
+        for (int i = 0; i < 128; i++) {
+            (void)__REG(HM_BDATA);
+        }
+        hsmmc_wait_int(HM_NORINT_TRCMPLT, HSMMC_TIMEOUT);
+    }
+
+    return false;
+}
+
+/*
+ * The iROM does not leave the card's relative address behind, and without
+ * it no application command can be sent.  Dropping the card back to the
+ * stand-by state makes it publish a new one, after which it is selected
+ * again.  A card left in stand-by can't be read, so asking for the address
+ * and reselecting are retried before giving up.
+ */
+static int hsmmc_get_rca(u32 *rca)
+{
+    int ret, tries;
+
+    ret = hsmmc_cmd(MMC_SELECT_CARD, 0, RSP_NONE);
+    if (ret) {
+        return ret;
+    }
+
+    for (tries = 0; tries < 3; tries++) {
+        ret = hsmmc_cmd(SD_SEND_RELATIVE_ADDR, 0, RSP_R6);
+        if (ret) {
+            continue;
+        }
+
+        *rca = __REG(HM_RSPREG0) & 0xffff0000;
+        ret = hsmmc_cmd_r1(MMC_SELECT_CARD, *rca, RSP_R1B);
+        if (ret == 0) {
+            break;
+        }
+    }
+
+    return ret;
+}
+
+static int hsmmc_set_bus_width(u32 rca)
+{
+    int ret;
+
+    if (__REGb(HM_HOSTCTL) & HM_HOSTCTL_WIDE4) {
+        return 0;
+    }
+
+    ret = hsmmc_cmd_r1(MMC_APP_CMD, rca, RSP_R1);
+    if (ret) {
+        return ret;
+    }
+
+    ret = hsmmc_cmd_r1(SD_APP_SET_BUS_WIDTH, 2, RSP_R1);
+    if (ret) {
+        return ret;
+    }
+
+    __REGb(HM_HOSTCTL) |= HM_HOSTCTL_WIDE4;
+    return 0;
+}
+
+/* ask the card to switch function group 1 to high-speed (CMD6 mode 1) */
+static int hsmmc_switch_high_speed(void)
+{
+    u32 status[16];
+    int ret;
+
+    __REGw(HM_BLKSIZE) = sizeof(status);
+    __REGw(HM_BLKCNT) = 1;
+    __REGw(HM_TRNMOD) = HM_TRNMOD_READ;
+
+    ret = hsmmc_cmd_r1(SD_SWITCH_FUNC, 0x80fffff1, RSP_R1 | HM_CMDREG_DATA);
+    if (ret) {
+        return ret;
+    }
+
+    ret = hsmmc_wait_int(HM_NORINT_BUFRDRDY, HSMMC_TIMEOUT);
+    if (ret) {
+        return ret;
+    }
+
+    for (int i = 0; i < 16; i++) {
+        status[i] = __REG(HM_BDATA);
+    }
+
+    ret = hsmmc_wait_int(HM_NORINT_TRCMPLT, HSMMC_TIMEOUT);
+    if (ret) {
+        return ret;
+    }
+
+    /* bits 379:376 of the status report the function now selected */
+    if ((((u8 *)status)[16] & 0xf) != 1) {
+        return -EOPNOTSUPP;
+    }
+
+    return 0;
+}
+
+/* run SDCLK from the EPLL derived base clock at no more than max_hz */
+static int hsmmc_set_clock(unsigned int max_hz)
+{
+    unsigned int base = clock_get_hsmmc();
+    unsigned int shift = 0;
+    unsigned int timeout = HSMMC_TIMEOUT;
+
+    while ((base >> shift) > max_hz && shift < 8) {
+        shift++;
+    }
+
+    __REGw(HM_CLKCON) &= ~HM_CLKCON_SDCLKEN;
+    __REG(HM_CONTROL2) = (__REG(HM_CONTROL2) & ~HM_CONTROL2_SELBASECLK_MASK)
+                       | HM_CONTROL2_SELBASECLK_EPLL;
+    __REGw(HM_CLKCON) = HM_CLKCON_SDCLKSEL((1 << shift) >> 1)
+                      | HM_CLKCON_ICLKEN;
+
+    while (!(__REGw(HM_CLKCON) & HM_CLKCON_ICLKSTA)) {
+        if (!--timeout) {
+            return -ETIMEDOUT;
+        }
+    }
+
+    __REGw(HM_CLKCON) |= HM_CLKCON_SDCLKEN;
+    return 0;
+}
+
+/*
+ * Move an SD card from the 1-bit, default speed bus the iROM used to a 4-bit
+ * bus at up to 50 MHz.  Each step is optional; whatever fails is left at the
+ * setting the iROM chose, and a high-speed bus that cannot read back a block
+ * is dropped again.  Only a card that can't be selected again is an error.
+ */
+static int hsmmc_set_speed(void)
+{
+    static u32 block[128];
+    u8 hostctl;
+    u16 clkcon;
+    u32 control2;
+    u32 rca;
+    int ret;
+
+    /* done even at 4 bits, the R6 reply clears the illegal CMD8 status */
+    if (!hsmmc_is_sd()) {
+        return 0;
+    }
+
+    /* a card that lost its address is left in stand-by, unreadable */
+    ret = hsmmc_get_rca(&rca);
+    if (ret) {
+        return ret;
+    }
+
+    hsmmc_set_bus_width(rca);
+
+    if (hsmmc_switch_high_speed()) {
+        return 0;
+    }
+
+    hostctl = __REGb(HM_HOSTCTL);
+    clkcon = __REGw(HM_CLKCON);
+    control2 = __REG(HM_CONTROL2);
+
+    __REGb(HM_HOSTCTL) = hostctl | HM_HOSTCTL_HSPD;
+    if (hsmmc_set_clock(50000000) == 0
+            && hsmmc_read_blocks(0, 1, block) == 0) {
+        return 0;
+    }
+
+    __REGw(HM_CLKCON) = clkcon & ~HM_CLKCON_SDCLKEN;
+    __REG(HM_CONTROL2) = control2;
+    __REGb(HM_HOSTCTL) = hostctl;
+    while (!(__REGw(HM_CLKCON) & HM_CLKCON_ICLKSTA));
+    __REGw(HM_CLKCON) = clkcon;
+    return 0;
+}
+#endif
+
+int hsmmc_init(void)
+{
+#if MOVI_INIT_REQUIRED
+    /* card identification is left to the iROM */
+    return -ENODEV;
+#else
+    if (!(__REGw(HM_CLKCON) & HM_CLKCON_ICLKSTA)) {
+        return -ENODEV;
+    }
+    __REGw(HM_CLKCON) |= HM_CLKCON_SDCLKEN;
+
+    high_capacity = MOVI_HIGH_CAPACITY & 1;
+
+    __REGb(HM_TIMEOUTCON) = 0x0e;
+
+    /* status is polled, never signalled */
+    __REGw(HM_NORINTSIGEN) = 0;
+    __REGw(HM_ERRINTSIGEN) = 0;
+    __REGw(HM_NORINTSTSEN) = 0x00ff;
+    __REGw(HM_ERRINTSTSEN) = 0x03ff;
+    __REGw(HM_ERRINTSTS) = 0xffff;
+    __REGw(HM_NORINTSTS) = 0xffff;
+
+#ifdef CONFIG_HSMMC_HIGHSPEED
+    return hsmmc_set_speed();
+#else
+    return 0;
+#endif
+#endif
+}
+
+/*
+ * Fill desc with ADMA2 transfer descriptors covering len bytes at addr,
+ * terminating the table after the last one.  Returns the number of
+ * descriptors used, or a negative error if addr or len are not word aligned
+ * or the table would need more than max entries.
+ */
+int hsmmc_adma_build(struct hsmmc_adma_desc *desc, int max, u32 addr, u32 len)
+{
+    int n = 0;
+
+    if ((addr | len) & 3) {
+        return -EINVAL;
+    }
+
+    while (len) {
+        u32 chunk = len > HSMMC_ADMA_MAXLEN ? HSMMC_ADMA_MAXLEN : len;
+
+        if (n == max) {
+            return -ENOSPC;
+        }
+
+        desc[n].attr = HM_ADMA_LEN(chunk) | HM_ADMA_ACT_TRAN | HM_ADMA_VALID;
+        desc[n].addr = addr;
+        addr += chunk;
+        len -= chunk;
+        n++;
+    }
+
+    if (n) {
+        desc[n - 1].attr |= HM_ADMA_END;
+    }
+
+    return n;
+}
+
+static int hsmmc_transfer_start(u32 start, u32 count, u32 *buf, bool write)
+{
+    int ret;
+
+    if (count == 0) {
+        return 0;
+    }
+
+    if (count > HSMMC_MAX_BLKCNT) {
+        return -EINVAL;
+    }
+
+    /* the table and the status bit below belong to the transfer in flight */
+    if (transfer_pending) {
+        return -EBUSY;
+    }
+    __REGw(HM_NORINTSTS) = HM_NORINT_TRCMPLT;
+
+    ret = hsmmc_adma_build(adma_table, HSMMC_ADMA_DESCS, (u32)buf,
+                           count * 512);
+    if (ret < 0) {
+        return ret;
+    }
+
+    /* the ADMA engine bypasses the D-cache for both table and data */
+    dcache_clean_range((u32)adma_table, (u32)&adma_table[ret]);
+    if (write) {
+        dcache_clean_range((u32)buf, (u32)buf + count * 512);
+    } else {
+        dcache_inval_range((u32)buf, (u32)buf + count * 512);
+    }
+
+    ret = hsmmc_wait_inhibit();
+    if (ret) {
+        return ret;
+    }
+
+    __REG(HM_ADMASYSADDR) = (u32)adma_table;
+    __REGb(HM_HOSTCTL) = (__REGb(HM_HOSTCTL) & ~HM_HOSTCTL_DMASEL_MASK)
+                       | HM_HOSTCTL_DMASEL_ADMA2;
+
+    __REGw(HM_BLKSIZE) = 512;
+    __REGw(HM_BLKCNT) = count;
+    __REGw(HM_TRNMOD) = HM_TRNMOD_DMAEN | HM_TRNMOD_BLKCNTEN
+                      | HM_TRNMOD_ACMD12EN | HM_TRNMOD_MULTIBLK
+                      | (write ? 0 : HM_TRNMOD_READ);
+
+    ret = hsmmc_cmd_r1(write ? MMC_WRITE_MULTIPLE_BLOCK
+                             : MMC_READ_MULTIPLE_BLOCK,
+                       high_capacity ? start : start << 9,
+                       RSP_R1 | HM_CMDREG_DATA);
+    if (ret) {
+        return ret;
+    }
+
+    transfer_pending = true;
+    return 0;
+}
+
+static int hsmmc_transfer_wait(void)
+{
+    if (!transfer_pending) {
+        return 0;
+    }
+
+    transfer_pending = false;
+    return hsmmc_wait_int(HM_NORINT_TRCMPLT, 0);
+}
+
+/*
+ * Start reading count blocks beginning at block start into a word aligned
+ * buffer.  The card is sent an open-ended CMD18 and the controller's ADMA2
+ * engine moves the data to memory while the CPU is free to do other work;
+ * once the block counter runs out the controller stops the card with an
+ * automatic CMD12.  hsmmc_read_wait() must be called before the buffer is
+ * used or another command is issued; until then another transfer is refused
+ * with -EBUSY.
+ */
+int hsmmc_read_start(u32 start, u32 count, u32 *buf)
+{
+    return hsmmc_transfer_start(start, count, buf, false);
+}
+
+int hsmmc_read_wait(void)
+{
+    return hsmmc_transfer_wait();
+}
+
+int hsmmc_read_blocks(u32 start, u32 count, u32 *buf)
+{
+    int ret;
+
+    ret = hsmmc_read_start(start, count, buf);
+    if (ret) {
+        return ret;
+    }
+
+    return hsmmc_transfer_wait();
+}
+
+/*
+ * Write count blocks from a word aligned buffer, beginning at block start.
+ * Transfer complete is only raised once the card has released the busy
+ * signal after the automatic CMD12, so the data is programmed on return.
+ */
+int hsmmc_write_blocks(u32 start, u32 count, const u32 *buf)
+{
+    int ret;
+
+    ret = hsmmc_transfer_start(start, count, (u32 *)buf, true);
+    if (ret) {
+        return ret;
+    }
+
+    return hsmmc_transfer_wait();
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __HSMMC_H
+#define __HSMMC_H
+
+#include <asm/types.h>
+
+/* largest transfer a single command can move (16-bit block count) */
+#define HSMMC_MAX_BLKCNT	65535
+
+/* bytes covered by one ADMA2 descriptor, and descriptors per transfer */
+#define HSMMC_ADMA_MAXLEN	0x8000
+#define HSMMC_ADMA_DESCS	((HSMMC_MAX_BLKCNT * 512 + HSMMC_ADMA_MAXLEN - 1) \
+                         / HSMMC_ADMA_MAXLEN)
+
+struct hsmmc_adma_desc {
+    u32 attr;   /* length in bits 31:16, attributes in bits 5:0 */
+    u32 addr;   /* word aligned destination */
+};
+
+int hsmmc_adma_build(struct hsmmc_adma_desc *desc, int max, u32 addr, u32 len);
+
+int hsmmc_init(void);
+int hsmmc_read_start(u32 start, u32 count, u32 *buf);
+int hsmmc_read_wait(void);
+int hsmmc_read_blocks(u32 start, u32 count, u32 *buf);
+int hsmmc_write_blocks(u32 start, u32 count, const u32 *buf);
+
+#endif /* __HSMMC_H */
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * nanoboot image loading
+ *
+ * The header block is read and checked, then every part is read from the
+ * same open file to its load address, so the directory is only searched and
+ * the FAT chain only followed once for all of them.  Parts go through the
+ * same path as separate files: they may be compressed, and their checksums
+ * are checked as they are read.
+ */
+
+#include <asm/types.h>
+#include <stdio.h>
+#include <string.h>
+#include "fatfs/ff.h"
+#include "config.h"
+#include "configfile.h"
+#include "crc32.h"
+#include "image.h"
+#include "load.h"
+#include "nbimg.h"
+#include "panic.h"
+#include "sha256.h"
+
+static u32 block[NBIMG_ALIGN / 4];
+
+static void part_digest(const struct nbimg_part *part, digest_t *digest)
+{
+    memset(digest, 0, sizeof(*digest));
+
+    if (part->flags & NBIMG_CRC32) {
+        digest->crc32_set = true;
+        digest->crc32 = part->crc32;
+    }
+    if (part->flags & NBIMG_SHA256) {
+        digest->sha256_set = true;
+        memcpy(digest->sha256, part->sha256, sizeof(digest->sha256));
+    }
+}
+
+static u32 part_address(const TCHAR *name, const struct nbimg_part *part,
+                        u32 fallback)
+{
+    u32 addr = part->load_address ? part->load_address : fallback;
+
+    /* the ATAGs live at the start of the first bank */
+    if (addr < PHYS_SDRAM_1 + 0x8000) {
+        panic("%s: part %d load address 0x%x is too low\n", name,
+              (int)part->type, addr);
+    }
+
+    return addr;
+}
+
+/* where a part goes in memory, or 0 for one that isn't loaded there */
+static u32 part_load_address(const TCHAR *name, const struct nbimg_part *part)
+{
+    switch (part->type) {
+    case NBIMG_KERNEL:
+        return part_address(name, part, config.kernel_address);
+    case NBIMG_INITRAMFS:
+        return part_address(name, part, config.initramfs_address);
+    case NBIMG_DTB:
+        return part_address(name, part, config.dtb_address);
+    default:
+        return 0;
+    }
+}
+
+/*
+ * The lowest address another part of the image loads to above part i, or 0
+ * if there is none.  A compressed part must unpack below it.
+ */
+static u32 part_end(const u32 *load_at, u32 count, u32 i)
+{
+    u32 end = 0, j;
+
+    for (j = 0; j < count; j++) {
+        if (load_at[j] > load_at[i] && (!end || load_at[j] < end)) {
+            end = load_at[j];
+        }
+    }
+
+    return end;
+}
+
+static void load_cmdline(const TCHAR *name, FIL *f,
+                         const struct nbimg_part *part)
+{
+    char cmdline[sizeof(config.cmdline)];
+    u8 digest[SHA256_DIGEST_SIZE];
+    struct sha256_ctx sha;
+    FRESULT fr;
+    UINT br;
+
+    if (part->size >= sizeof(cmdline)) {
+        panic("%s: command line too long\n", name);
+    }
+
+    fr = f_lseek(f, part->offset);
+    if (fr == FR_OK) {
+        fr = f_read(f, cmdline, part->size, &br);
+    }
+    if (fr != FR_OK || br != part->size) {
+        panic("error reading %s: %d\n", name, (int)fr);
+    }
+    cmdline[part->size] = '\0';
+
+    if (part->flags & NBIMG_CRC32 && crc32(0, cmdline, br) != part->crc32) {
+        panic("%s: command line crc32 mismatch\n", name);
+    }
+    if (part->flags & NBIMG_SHA256) {
+        sha256_init(&sha);
+        sha256_update(&sha, cmdline, br);
+        sha256_final(&sha, digest);
+        if (memcmp(digest, part->sha256, sizeof(digest)) != 0) {
+            panic("%s: command line sha256 mismatch\n", name);
+        }
+    }
+
+    /* a trailing newline is left by most ways of writing the file */
+    while (br && (cmdline[br - 1] == '\n' || cmdline[br - 1] == '\r')) {
+        cmdline[--br] = '\0';
+    }
+
+    config_set_cmdline(cmdline);
+}
+
+void image_load(const TCHAR *name)
+{
+    const struct nbimg_header *hdr = (const struct nbimg_header *)block;
+    const struct nbimg_part *parts = (const struct nbimg_part *)(hdr + 1);
+    const struct nbimg_part *part;
+    bool have_kernel = false;
+    u32 load_at[NBIMG_MAX_PARTS];
+    digest_t digest;
+    FRESULT fr;
+    FIL f;
+    UINT br;
+    u32 i, j;
+
+    fr = f_open(&f, name, FA_READ);
+    if (fr != FR_OK) {
+        panic("error opening %s: %d\n", name, (int)fr);
+    }
+
+    fr = f_read(&f, block, sizeof(block), &br);
+    if (fr != FR_OK) {
+        panic("error reading %s: %d\n", name, (int)fr);
+    }
+    if (br != sizeof(block) || hdr->magic != NBIMG_MAGIC) {
+        panic("%s is not a nanoboot image\n", name);
+    }
+    if (hdr->version != NBIMG_VERSION) {
+        panic("%s: unsupported image version %d\n", name, hdr->version);
+    }
+    if (hdr->count > NBIMG_MAX_PARTS
+            || crc32(0, parts, hdr->count * sizeof(*parts)) != hdr->crc32) {
+        panic("%s: corrupt header\n", name);
+    }
+
+    for (i = 0; i < hdr->count; i++) {
+        part = &parts[i];
+        if (part->offset < NBIMG_ALIGN || part->offset % NBIMG_ALIGN
+                || part->size > f_size(&f)
+                || part->offset > f_size(&f) - part->size) {
+            panic("%s: part %d is outside the file\n", name, i);
+        }
+
+        /* a compressed part unpacks to more, which part_end() bounds */
+        load_at[i] = part_load_address(name, part);
+        for (j = 0; j < i; j++) {
+            if (load_at[i] && load_at[j]
+                    && load_at[i] < load_at[j] + parts[j].size
+                    && load_at[j] < load_at[i] + part->size) {
+                panic("%s: parts %d and %d overlap in memory\n", name, j, i);
+            }
+        }
+    }
+
+    for (i = 0; i < hdr->count; i++) {
+        part = &parts[i];
+        part_digest(part, &digest);
+
+        switch (part->type) {
+        case NBIMG_KERNEL:
+            config.kernel_address = load_at[i];
+            config.kernel_size = load_part("kernel", &f, part->offset,
+                    part->size, (void *)config.kernel_address,
+                    part_end(load_at, hdr->count, i), &digest);
+            have_kernel = true;
+            break;
+
+        case NBIMG_INITRAMFS:
+            config.initramfs_address = load_at[i];
+            config.initramfs_size = load_part("initramfs", &f, part->offset,
+                    part->size, (void *)config.initramfs_address,
+                    part_end(load_at, hdr->count, i), &digest);
+            break;
+
+        case NBIMG_DTB:
+            config.dtb_address = load_at[i];
+            if (config.dtb_address & 7) {
+                panic("%s: device tree load address must be a multiple of "
+                      "8\n", name);
+            }
+            config.dtb_size = load_part("dtb", &f, part->offset, part->size,
+                                        (void *)config.dtb_address,
+                                        part_end(load_at, hdr->count, i),
+                                        &digest);
+            break;
+
+        case NBIMG_CMDLINE:
+            load_cmdline(name, &f, part);
+            break;
+
+        default:
+            printf("%s: skipping part %d of type %d\n", name, i,
+                   (int)part->type);
+            break;
+        }
+    }
+
+    f_close(&f);
+
+    if (!have_kernel) {
+        panic("%s has no kernel\n", name);
+    }
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <asm/types.h>
+#include <stdio.h>
+#include <string.h>
+#include "fatfs/ff.h"
+#include "config.h"
+#include "configfile.h"
+#include "fdt.h"
+#include "layout.h"
+#include "load.h"
+#include "panic.h"
+
+/*
+ * Load address planning for "auto_address".
+ *
+ * The zImage decompressor writes the kernel to KERNEL_TEXT_ADDR.  If the
+ * zImage itself sits where the kernel will go, it first copies itself out
+ * of the way, and if the initramfs overlaps the kernel it gets moved too.
+ * Both are multi-megabyte copies with the caches off.  Here the initramfs is
+ * put at the top of memory, the device tree below it with room to grow, and
+ * the zImage below that, which leaves the most room for the decompressed
+ * kernel.
+ */
+
+#define ZIMAGE_MAGIC        0x016f2818
+#define ZIMAGE_MAGIC_WORD   9       /* magic, start, end at 0x24 */
+
+/* room for the decompressor's bss, stack and heap after the zImage */
+#define ZIMAGE_SLACK        0x20000
+
+/* a decompressed kernel is rarely more than this many times its zImage */
+#define ZIMAGE_RATIO        4
+
+#define ALIGN_DOWN(x, a)    ((x) & ~((a) - 1))
+
+/*
+ * Size of a file from its directory entry, optionally with the start of its
+ * contents.  Returns 0 if the file can't be opened.
+ */
+static size_t file_peek(const TCHAR *name, u32 *buf, UINT len)
+{
+    FIL f;
+    UINT br;
+    size_t size;
+
+    if (f_open(&f, name, FA_READ) != FR_OK) {
+        return 0;
+    }
+
+    size = f_size(&f);
+    if (len && (f_read(&f, buf, len, &br) != FR_OK || br != len)) {
+        size = 0;
+    }
+
+    f_close(&f);
+    return size;
+}
+
+void layout_plan(void)
+{
+    u32 hdr[ZIMAGE_MAGIC_WORD + 3];
+    u32 top = CFG_NANOBOOT_BASE;
+    u32 kernel_at;
+    size_t size;
+
+    if (strlen(config.initramfs)) {
+        size = file_peek(config.initramfs, hdr, sizeof(u32));
+        if (size && config.device == DEVICE_MINI2451
+                && size <= PHYS_SDRAM_2_SIZE) {
+            /* bank 2 is all the initramfs' */
+            config.initramfs_address = PHYS_SDRAM_2;
+        } else if (size && !load_compressed(hdr, sizeof(u32))) {
+            top = ALIGN_DOWN(top - size, 4096);
+            config.initramfs_address = top;
+        } else if (size && config.initramfs_address >= PHYS_SDRAM_1
+                && config.initramfs_address < top) {
+            /* it unpacks upwards from its address, keep the rest below */
+            top = ALIGN_DOWN(config.initramfs_address, 4096);
+        }
+        /* a compressed one keeps its address, its unpacked size is unknown */
+        printf("auto_address: %s at 0x%x\n", config.initramfs,
+               config.initramfs_address);
+    }
+
+    if (strlen(config.dtb)) {
+        size = file_peek(config.dtb, NULL, 0);
+        if (size) {
+            top = ALIGN_DOWN(top - size - FDT_GROW, 4096);
+            config.dtb_address = top;
+            printf("auto_address: %s at 0x%x\n", config.dtb, top);
+        }
+    }
+
+    size = file_peek(config.kernel, hdr, sizeof(hdr));
+    if (!size) {
+        return;
+    }
+
+    if (load_compressed(hdr, sizeof(hdr))) {
+        printf("auto_address: %s is compressed, keeping 0x%x\n",
+               config.kernel, config.kernel_address);
+        return;
+    }
+
+    if (hdr[ZIMAGE_MAGIC_WORD] != ZIMAGE_MAGIC) {
+        printf("auto_address: %s has no zImage header, loading it at 0x%x\n",
+               config.kernel, KERNEL_TEXT_ADDR);
+        config.kernel_address = KERNEL_TEXT_ADDR;
+        return;
+    }
+
+    /* a zImage linked to a fixed address has to run from there */
+    if (hdr[ZIMAGE_MAGIC_WORD + 1] != 0) {
+        config.kernel_address = hdr[ZIMAGE_MAGIC_WORD + 1];
+        printf("auto_address: %s at 0x%x\n", config.kernel,
+               config.kernel_address);
+        return;
+    }
+
+    /* the header's end covers anything past the end of the file */
+    if (hdr[ZIMAGE_MAGIC_WORD + 2] > size) {
+        size = hdr[ZIMAGE_MAGIC_WORD + 2];
+    }
+    kernel_at = ALIGN_DOWN(top - size - ZIMAGE_SLACK, 4096);
+    if (kernel_at < KERNEL_TEXT_ADDR + size) {
+        panic("auto_address: not enough memory for %s\n", config.kernel);
+    }
+
+    if (kernel_at < KERNEL_TEXT_ADDR + ZIMAGE_RATIO * size) {
+        printf("auto_address: little room after the kernel, the zImage may "
+               "relocate itself\n");
+    }
+
+    config.kernel_address = kernel_at;
+    printf("auto_address: %s at 0x%x\n", config.kernel, kernel_at);
+}
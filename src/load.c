@@ -0,0 +1,532 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Image loading
+ *
+ * The start of each image is read to its load address and looked at.  Plain
+ * images are then read in place in large chunks.  Compressed ones are
+ * copied out to a staging buffer and decompressed to the load address,
+ * with the rest of the file pulled into the staging buffer as the
+ * decompressor asks for it.  With the HSMMC driver the staging buffer is
+ * split in two, and the card fills one half while the other is being
+ * decompressed.
+ *
+ * Checksums given in nanoboot.txt are worked out over the file as it comes
+ * in, each piece while the card is already busy with the next one, so
+ * checking an image costs little more than reading it.
+ */
+
+#include <asm/types.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include "fatfs/ff.h"
+#include "config.h"
+#include "configfile.h"
+#include "crc32.h"
+#include "extents.h"
+#include "gunzip.h"
+#include "hsmmc.h"
+#include "load.h"
+#include "lz4.h"
+#include "mmu.h"
+#include "panic.h"
+#include "sha256.h"
+#include "stream.h"
+#include "timer.h"
+
+/* plain images are read this much at a time, with room for work between */
+#define LOAD_CHUNK  (1024*1024)
+
+/* compressed input is staged this much at a time */
+#define STAGE_SIZE  (256*1024)
+#define STAGE_HALF  (STAGE_SIZE / 2)
+
+/* the card writes one half while the CPU reads the other, keep them apart */
+static u32 stage[STAGE_SIZE / 4] __attribute__((aligned(CACHE_LINE_SIZE)));
+
+/*
+ * Bytes of SDRAM from start up to the next image, nanoboot or the end of
+ * bank 2, or 0 if start isn't somewhere an image can go.
+ */
+static size_t room_at(u32 start)
+{
+    u32 end;
+
+    if (start >= PHYS_SDRAM_1 && start < CFG_NANOBOOT_BASE) {
+        end = CFG_NANOBOOT_BASE;
+    } else if (config.device == DEVICE_MINI2451 && start >= PHYS_SDRAM_2
+            && start < PHYS_SDRAM_2 + PHYS_SDRAM_2_SIZE) {
+        end = PHYS_SDRAM_2 + PHYS_SDRAM_2_SIZE;
+    } else {
+        return 0;
+    }
+
+    /* stop short of the next image up, loaded or still to come */
+    if (config.kernel_address > start && config.kernel_address < end) {
+        end = config.kernel_address;
+    }
+    if ((strlen(config.initramfs) || config.initramfs_size)
+            && config.initramfs_address > start
+            && config.initramfs_address < end) {
+        end = config.initramfs_address;
+    }
+    if ((strlen(config.dtb) || config.dtb_size)
+            && config.dtb_address > start && config.dtb_address < end) {
+        end = config.dtb_address;
+    }
+
+    return end - start;
+}
+
+/* running checksums of the image being loaded */
+static struct {
+    const digest_t *want;
+    u32 crc;
+    struct sha256_ctx sha;
+} verify;
+
+static bool verify_wanted(const digest_t *want)
+{
+    return want && (want->crc32_set || want->sha256_set);
+}
+
+static void verify_start(const digest_t *want)
+{
+    verify.want = verify_wanted(want) ? want : NULL;
+    verify.crc = 0;
+    sha256_init(&verify.sha);
+}
+
+static void verify_update(const void *buf, size_t len)
+{
+    if (!verify.want || !len) {
+        return;
+    }
+
+    if (verify.want->crc32_set) {
+        verify.crc = crc32(verify.crc, buf, len);
+    }
+    if (verify.want->sha256_set) {
+        sha256_update(&verify.sha, buf, len);
+    }
+}
+
+static void verify_finish(const TCHAR *name)
+{
+    u8 digest[SHA256_DIGEST_SIZE];
+
+    if (!verify.want) {
+        return;
+    }
+
+    if (verify.want->crc32_set && verify.crc != verify.want->crc32) {
+        panic("%s: crc32 is %08x, expected %08x\n", name, verify.crc,
+              verify.want->crc32);
+    }
+
+    if (verify.want->sha256_set) {
+        sha256_final(&verify.sha, digest);
+        if (memcmp(digest, verify.want->sha256, sizeof(digest)) != 0) {
+            panic("%s: sha256 mismatch\n", name);
+        }
+    }
+
+    verify.want = NULL;
+}
+
+/* the part of an open file a compressed image is read from */
+struct file_part {
+    FIL *f;
+    size_t left;        /* bytes of it not read yet */
+};
+
+static int file_refill(struct stream *s)
+{
+    struct file_part *part = s->priv;
+    UINT n, br;
+
+    /* keep the boot timer's wrap count while a decoder runs */
+    timer_ticks();
+
+    n = part->left < sizeof(stage) ? part->left : sizeof(stage);
+    if (f_read(part->f, stage, n, &br) != FR_OK) {
+        s->error = -EIO;
+        return -EIO;
+    }
+    part->left -= br;
+
+    s->p = (const u8 *)stage;
+    s->end = (const u8 *)stage + br;
+    verify_update(s->p, br);
+    return br;
+}
+
+#ifdef CONFIG_HSMMC
+/* runs of sectors a compressed image may be in, for reading ahead */
+#define READAHEAD_EXTENTS   64
+
+static struct {
+    FEXTENT ext[READAHEAD_EXTENTS];
+    UINT count;         /* extents in ext */
+    UINT next;          /* extent the next read comes from */
+    DWORD sect;         /* where in it */
+    size_t left;        /* file bytes not asked for yet */
+    size_t pending;     /* bytes of the read in flight */
+    int half;           /* staging half it goes to */
+} ra;
+
+/*
+ * Ask the card for the next run of the file, at most max sectors, to buf.
+ */
+static int readahead_start_to(u32 *buf, DWORD max)
+{
+    FEXTENT *e = &ra.ext[ra.next];
+    DWORD count;
+    int ret;
+
+    count = e->sect + e->nsect - ra.sect;
+    if (count > max) {
+        count = max;
+    }
+
+    ret = hsmmc_read_start(ra.sect, count, buf);
+    if (ret) {
+        return ret;
+    }
+
+    ra.pending = count * 512 < ra.left ? count * 512 : ra.left;
+    ra.left -= ra.pending;
+    ra.sect += count;
+    if (ra.sect == e->sect + e->nsect && ++ra.next < ra.count) {
+        ra.sect = ra.ext[ra.next].sect;
+    }
+
+    return 0;
+}
+
+/*
+ * Ask the card for the next run of the file, up to half the staging buffer.
+ */
+static int readahead_start(void)
+{
+    if (!ra.left) {
+        return 0;
+    }
+
+    return readahead_start_to(stage + ra.half * STAGE_HALF / 4,
+                              STAGE_HALF / 512);
+}
+
+static int readahead_refill(struct stream *s)
+{
+    int ret;
+
+    ret = hsmmc_read_wait();
+    if (ret) {
+        s->error = -EIO;
+        return -EIO;
+    }
+
+    s->p = (const u8 *)(stage + ra.half * STAGE_HALF / 4);
+    s->end = s->p + ra.pending;
+    ret = ra.pending;
+
+    ra.half ^= 1;
+    ra.pending = 0;
+    if (readahead_start()) {
+        s->error = -EIO;
+        return -EIO;
+    }
+
+    /* the card is on to the next chunk already */
+    verify_update(s->p, ret);
+    return ret;
+}
+
+/*
+ * Find where in f offset, a multiple of the sector size, is, to read len
+ * bytes from there.  Returns false if the file is too fragmented to tell.
+ */
+static bool readahead_seek(FIL *f, size_t offset, size_t len)
+{
+    DWORD skip = offset / 512;
+
+    if (f_extents(f, ra.ext, READAHEAD_EXTENTS, &ra.count) != FR_OK) {
+        return false;
+    }
+
+    ra.next = 0;
+    while (ra.next < ra.count && skip >= ra.ext[ra.next].nsect) {
+        skip -= ra.ext[ra.next++].nsect;
+    }
+    ra.sect = ra.next < ra.count ? ra.ext[ra.next].sect + skip : 0;
+    ra.left = len;
+    ra.pending = 0;
+    return true;
+}
+
+/*
+ * Set s up to read len bytes of f from offset on, reading ahead into the
+ * staging half other than the one holding the first chunk.  Returns false if
+ * the file is too fragmented to do so.
+ */
+static bool readahead_init(struct stream *s, FIL *f, size_t offset,
+                           size_t len)
+{
+    if (!readahead_seek(f, offset, len)) {
+        return false;
+    }
+
+    ra.half = 1;
+    s->refill = readahead_refill;
+    return readahead_start() == 0;
+}
+
+/*
+ * Read len bytes of a plain image from offset on straight to p, checksumming
+ * each chunk while the card fetches the one after it.  A partial last
+ * sector goes through the staging buffer so nothing past the end of the
+ * image is written.  Returns false if the file is too fragmented to do so.
+ */
+static bool read_verified(const TCHAR *name, FIL *f, BYTE *p, size_t offset,
+                          size_t len)
+{
+    BYTE *done = p;
+    DWORD max;
+
+    if (!readahead_seek(f, offset, len)) {
+        return false;
+    }
+
+    while (ra.left >= 512) {
+        max = ra.left / 512;
+        if (max > LOAD_CHUNK / 512) {
+            max = LOAD_CHUNK / 512;
+        }
+        if (readahead_start_to((u32 *)p, max)) {
+            goto error;
+        }
+        verify_update(done, p - done);
+        done = p;
+        if (hsmmc_read_wait()) {
+            goto error;
+        }
+        p += ra.pending;
+    }
+    verify_update(done, p - done);
+
+    if (ra.left) {
+        if (readahead_start_to(stage, 1) || hsmmc_read_wait()) {
+            goto error;
+        }
+        memcpy(p, stage, ra.pending);
+        verify_update(p, ra.pending);
+    }
+
+    return true;
+
+error:
+    panic("error reading %s\n", name);
+    return false;
+}
+#else
+/* reads block without the HSMMC driver, there is nothing to overlap */
+static bool read_verified(const TCHAR *name, FIL *f, BYTE *p, size_t offset,
+                          size_t len)
+{
+    return false;
+}
+#endif
+
+static void read_chunks(const TCHAR *name, FIL *f, BYTE *p, size_t len)
+{
+    FRESULT fr;
+    UINT n, br;
+
+    while (len) {
+        n = len > LOAD_CHUNK ? LOAD_CHUNK : len;
+
+        timer_ticks();
+        fr = f_read(f, p, n, &br);
+        if (fr != FR_OK) {
+            panic("error reading %s: %d\n", name, (int)fr);
+        }
+        if (br != n) {
+            panic("error reading %s: short read\n", name);
+        }
+        verify_update(p, n);
+        p += n;
+        len -= n;
+    }
+}
+
+/*
+ * Whether an image starting with buf is one load_image() decompresses.
+ */
+bool load_compressed(const void *buf, size_t len)
+{
+    return lz4_probe(buf, len) || gunzip_probe(buf, len);
+}
+
+/*
+ * Load size bytes of f from offset on, a multiple of the sector size, to
+ * load_at, stopping short of end unless it is 0.  A plain image is recorded
+ * in the extent cache slot if there is one.  Returns the size of the loaded
+ * image.
+ */
+static size_t load_region(const TCHAR *name, FIL *f, size_t offset,
+                          size_t size, void *load_at, u32 end, int slot,
+                          const digest_t *digest)
+{
+    FRESULT fr;
+    size_t room, n;
+    int ret;
+
+    room = room_at((u32)load_at);
+    if (end > (u32)load_at && end - (u32)load_at < room) {
+        room = end - (u32)load_at;
+    }
+
+    fr = f_lseek(f, offset);
+    if (fr != FR_OK) {
+        panic("error reading %s: %d\n", name, (int)fr);
+    }
+
+    n = size < STAGE_HALF ? size : STAGE_HALF;
+    if (n > room) {
+        goto nospace;
+    }
+    verify_start(digest);
+    read_chunks(name, f, load_at, n);
+
+    if (load_compressed(load_at, n)) {
+        struct file_part part = {
+            .f = f,
+            .left = size - n,
+        };
+        struct stream s = {
+            .p = (const u8 *)stage,
+            .end = (const u8 *)stage + n,
+            .refill = file_refill,
+            .priv = &part,
+        };
+
+        memcpy(stage, load_at, n);
+#ifdef CONFIG_HSMMC
+        if (!readahead_init(&s, f, offset + n, size - n)) {
+            s.refill = file_refill;
+        }
+#endif
+        if (lz4_probe(stage, n)) {
+            ret = lz4_decode(&s, load_at, room);
+        } else {
+            ret = gunzip_decode(&s, load_at, room);
+        }
+        if (ret == -ENOSPC) {
+            goto nospace;
+        }
+        if (ret < 0) {
+            panic("error decompressing %s: %d\n", name, ret);
+        }
+
+        /* anything after the compressed data is still part of the image */
+        if (verify.want) {
+            while (s.refill(&s) > 0) {
+            }
+            if (s.error) {
+                panic("error reading %s: %d\n", name, s.error);
+            }
+        }
+#ifdef CONFIG_HSMMC
+        /* the card may still be reading ahead into the staging buffer */
+        if (hsmmc_read_wait()) {
+            panic("error reading %s\n", name);
+        }
+#endif
+        verify_finish(name);
+
+        printf(" loaded %u bytes from %u compressed\n", (unsigned int)ret,
+               (unsigned int)size);
+        return ret;
+    }
+
+    if (size > room) {
+        goto nospace;
+    }
+    if (!verify.want || !read_verified(name, f, (BYTE *)load_at + n,
+                                       offset + n, size - n)) {
+        read_chunks(name, f, (BYTE *)load_at + n, size - n);
+    }
+    verify_finish(name);
+
+    if (config.extent_cache && slot >= 0) {
+        extents_record(slot, f);
+    }
+
+    printf(" loaded %u bytes\n", (unsigned int)size);
+    return size;
+
+nospace:
+    panic("%s doesn't fit in memory at 0x%x\n", name, (u32)load_at);
+    return 0;
+}
+
+/*
+ * Load a file to load_at, using extent cache slot unless it is -1.
+ */
+size_t load_image(const TCHAR *name, void *load_at, int slot,
+                  const digest_t *digest)
+{
+    FRESULT fr;
+    FIL f;
+    size_t size;
+
+    printf("loading %s...", name);
+
+    fr = f_open(&f, name, FA_READ);
+    if (fr != FR_OK) {
+        panic("error opening %s: %d\n", name, (int)fr);
+    }
+
+    size = f_size(&f);
+
+    /* only plain images are ever recorded, and they are read unchecked */
+    if (config.extent_cache && slot >= 0 && !verify_wanted(digest)
+            && size <= room_at((u32)load_at)
+            && extents_load(slot, &f, load_at) == 0) {
+        printf(" loaded %u bytes\n", (unsigned int)size);
+    } else {
+        size = load_region(name, &f, 0, size, load_at, 0, slot, digest);
+    }
+
+    f_close(&f);
+    return size;
+}
+
+/*
+ * Load size bytes of an already open file from offset on, a multiple of the
+ * sector size, as if they were a file of their own.  Unless end is 0, the
+ * loaded image must stop short of it as well as of the other images.
+ */
+size_t load_part(const TCHAR *name, FIL *f, size_t offset, size_t size,
+                 void *load_at, u32 end, const digest_t *digest)
+{
+    printf("loading %s...", name);
+    return load_region(name, f, offset, size, load_at, end, -1, digest);
+}
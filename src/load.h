@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __LOAD_H
+#define __LOAD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "fatfs/ff.h"
+#include "configfile.h"
+
+bool load_compressed(const void *buf, size_t len);
+size_t load_image(const TCHAR *name, void *load_at, int slot,
+                  const digest_t *digest);
+size_t load_part(const TCHAR *name, FIL *f, size_t offset, size_t size,
+                 void *load_at, u32 end, const digest_t *digest);
+
+#endif /* __LOAD_H */
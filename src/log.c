@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <asm/types.h>
+#include <string.h>
+#include "config.h"
+#include "log.h"
+#include "serial.h"
+
+static bool log_quiet;
+
+#ifdef CONFIG_LOG
+static struct log_header *const log = (struct log_header *)CFG_LOG_BASE;
+static char *const log_text =
+    (char *)(CFG_LOG_BASE + sizeof(struct log_header));
+static u32 log_pos;
+
+void log_init(void)
+{
+    log->magic = LOG_MAGIC;
+    log->size = CFG_LOG_SIZE - sizeof(struct log_header);
+    log->head = 0;
+    log->reserved = 0;
+    log_pos = 0;
+}
+
+static void log_append(const char *buf, size_t len)
+{
+    size_t n;
+
+    log->head += len;
+    while (len) {
+        n = log->size - log_pos;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(log_text + log_pos, buf, n);
+        log_pos += n;
+        if (log_pos == log->size) {
+            log_pos = 0;
+        }
+        buf += n;
+        len -= n;
+    }
+}
+#else
+void log_init(void)
+{
+}
+
+static void log_append(const char *buf, size_t len)
+{
+}
+#endif
+
+/*
+ * Stop echoing the log on the serial port.  It is still kept in RAM.
+ */
+void log_set_quiet(bool quiet)
+{
+    log_quiet = quiet;
+}
+
+/*
+ * Where printf output ends up.
+ */
+void log_write(const char *buf, size_t len)
+{
+    log_append(buf, len);
+
+    if (!log_quiet) {
+        serial_write(buf, len);
+    }
+}
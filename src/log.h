@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __LOG_H
+#define __LOG_H
+
+#include <asm/types.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define LOG_MAGIC       0x474f4c4e  /* "NLOG" */
+
+/*
+ * The log starts with this header and the text follows it.  head counts
+ * every byte ever written; once it passes size the text has wrapped and the
+ * oldest byte is at head % size.
+ */
+struct log_header {
+    u32 magic;
+    u32 size;       /* bytes of text after the header */
+    u32 head;
+    u32 reserved;
+};
+
+void log_init(void);
+void log_set_quiet(bool quiet);
+void log_write(const char *buf, size_t len);
+
+#endif /* __LOG_H */
@@ -0,0 +1,337 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * LZ4 decompression
+ *
+ * Decodes LZ4 frames, as written by the lz4 tool, and the legacy format the
+ * kernel build uses, straight to their final place in memory.  Input is
+ * pulled from a stream as it is needed, so only the compressed chunk being
+ * worked on has to be staged.  Output is flat, so matches are copied from
+ * what has already been written and no separate window is kept.  Block and
+ * content checksums are skipped.
+ */
+
+#include <asm/types.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+#include "lz4.h"
+
+#define LZ4_MAGIC           0x184d2204
+#define LZ4_LEGACY_MAGIC    0x184c2102
+#define LZ4_SKIP_MAGIC      0x184d2a50  /* low nibble is free */
+
+/* frame descriptor flags */
+#define FLG_VERSION_MASK    0xc0
+#define FLG_VERSION         0x40
+#define FLG_BLOCK_CSUM      0x10
+#define FLG_CONTENT_SIZE    0x08
+#define FLG_CONTENT_CSUM    0x04
+#define FLG_RESERVED        0x02
+#define FLG_DICT_ID         0x01
+
+/* block size word, high bit set for a stored block */
+#define BLOCK_STORED        0x80000000
+
+struct lz4_out {
+    u8 *start;
+    u8 *p;
+    u8 *end;
+};
+
+static int lz4_fail(struct stream *s)
+{
+    return s->error ? s->error : -EINVAL;
+}
+
+static u32 get_le32(struct stream *s, int *err)
+{
+    u32 v = 0;
+    int i, c;
+
+    for (i = 0; i < 32; i += 8) {
+        c = stream_getc(s);
+        if (c < 0) {
+            *err = lz4_fail(s);
+            return 0;
+        }
+        v |= (u32)c << i;
+    }
+
+    return v;
+}
+
+/*
+ * The next byte of a block, with *len counting down what is left of it.
+ */
+static int block_getc(struct stream *s, u32 *len)
+{
+    if (!*len) {
+        return -1;
+    }
+    (*len)--;
+    return stream_getc(s);
+}
+
+/*
+ * Length fields: a nibble of 15 continues in bytes until one isn't 255.
+ */
+static int block_length(struct stream *s, u32 *len, u32 *n)
+{
+    int c;
+
+    if (*n != 15) {
+        return 0;
+    }
+
+    do {
+        c = block_getc(s, len);
+        if (c < 0) {
+            return lz4_fail(s);
+        }
+        *n += c;
+    } while (c == 255);
+
+    return 0;
+}
+
+static int lz4_block(struct stream *s, u32 len, struct lz4_out *o)
+{
+    u32 lit, mlen, off;
+    int token, lo, hi, ret;
+    u8 *m;
+
+    while (len) {
+        token = block_getc(s, &len);
+        if (token < 0) {
+            return lz4_fail(s);
+        }
+
+        lit = token >> 4;
+        ret = block_length(s, &len, &lit);
+        if (ret) {
+            return ret;
+        }
+        if (lit > len) {
+            return -EINVAL;
+        }
+        if (lit > o->end - o->p) {
+            return -ENOSPC;
+        }
+        if (stream_read(s, o->p, lit) != lit) {
+            return lz4_fail(s);
+        }
+        o->p += lit;
+        len -= lit;
+
+        /* the last sequence is literals only */
+        if (!len) {
+            break;
+        }
+
+        lo = block_getc(s, &len);
+        hi = block_getc(s, &len);
+        if (lo < 0 || hi < 0) {
+            return lz4_fail(s);
+        }
+        off = lo | hi << 8;
+
+        mlen = token & 15;
+        ret = block_length(s, &len, &mlen);
+        if (ret) {
+            return ret;
+        }
+        mlen += 4;
+
+        if (off == 0 || off > o->p - o->start) {
+            return -EINVAL;
+        }
+        if (mlen > o->end - o->p) {
+            return -ENOSPC;
+        }
+
+        /* most matches are short, memcpy() only pays off on long ones */
+        m = o->p - off;
+        if (off >= mlen && mlen >= 32) {
+            memcpy(o->p, m, mlen);
+            o->p += mlen;
+        } else {
+            while (mlen--) {
+                *o->p++ = *m++;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int lz4_stored(struct stream *s, u32 len, struct lz4_out *o)
+{
+    if (len > o->end - o->p) {
+        return -ENOSPC;
+    }
+    if (stream_read(s, o->p, len) != len) {
+        return lz4_fail(s);
+    }
+    o->p += len;
+    return 0;
+}
+
+static int lz4_skip(struct stream *s, u32 len)
+{
+    return stream_read(s, NULL, len) == len ? 0 : lz4_fail(s);
+}
+
+static int lz4_frame(struct stream *s, struct lz4_out *o)
+{
+    int flg, bd, ret = 0;
+    u32 len, lo, hi;
+
+    flg = stream_getc(s);
+    bd = stream_getc(s);
+    if (flg < 0 || bd < 0) {
+        return lz4_fail(s);
+    }
+
+    if ((flg & FLG_VERSION_MASK) != FLG_VERSION
+            || (flg & (FLG_RESERVED | FLG_DICT_ID))) {
+        return -EINVAL;
+    }
+
+    if (flg & FLG_CONTENT_SIZE) {
+        lo = get_le32(s, &ret);
+        hi = get_le32(s, &ret);
+        if (ret) {
+            return ret;
+        }
+        if (hi || lo > o->end - o->p) {
+            return -ENOSPC;
+        }
+    }
+
+    /* header checksum */
+    ret = lz4_skip(s, 1);
+
+    while (!ret) {
+        len = get_le32(s, &ret);
+        if (ret || !len) {
+            break;
+        }
+
+        if (len & BLOCK_STORED) {
+            ret = lz4_stored(s, len & ~BLOCK_STORED, o);
+        } else {
+            ret = lz4_block(s, len, o);
+        }
+
+        if (!ret && (flg & FLG_BLOCK_CSUM)) {
+            ret = lz4_skip(s, 4);
+        }
+    }
+
+    if (!ret && (flg & FLG_CONTENT_CSUM)) {
+        ret = lz4_skip(s, 4);
+    }
+
+    return ret;
+}
+
+/*
+ * Legacy frames are a run of compressed blocks up to the end of the input
+ * or the next magic number.
+ */
+static int lz4_legacy(struct stream *s, struct lz4_out *o)
+{
+    int ret = 0;
+    u32 len;
+
+    while (!stream_eof(s)) {
+        len = get_le32(s, &ret);
+        if (ret) {
+            return ret;
+        }
+        if (len == LZ4_LEGACY_MAGIC) {
+            continue;
+        }
+
+        ret = lz4_block(s, len, o);
+        if (ret) {
+            return ret;
+        }
+    }
+
+    return s->error;
+}
+
+bool lz4_probe(const void *buf, size_t len)
+{
+    const u8 *p = buf;
+    u32 magic;
+
+    if (len < 4) {
+        return false;
+    }
+
+    magic = p[0] | p[1] << 8 | p[2] << 16 | p[3] << 24;
+    return magic == LZ4_MAGIC || magic == LZ4_LEGACY_MAGIC;
+}
+
+/*
+ * Decompress everything s holds to out, writing no more than max bytes.
+ * Returns the decompressed size or a negative error.
+ */
+int lz4_decode(struct stream *s, void *out, size_t max)
+{
+    struct lz4_out o = {
+        .start = out,
+        .p = out,
+        .end = (u8 *)out + max,
+    };
+    u32 magic, len;
+    int ret = 0;
+
+    do {
+        magic = get_le32(s, &ret);
+        if (ret) {
+            return ret;
+        }
+
+        if (magic == LZ4_MAGIC) {
+            ret = lz4_frame(s, &o);
+        } else if (magic == LZ4_LEGACY_MAGIC) {
+            ret = lz4_legacy(s, &o);
+        } else if ((magic & ~0xf) == LZ4_SKIP_MAGIC) {
+            len = get_le32(s, &ret);
+            if (!ret) {
+                ret = lz4_skip(s, len);
+            }
+        } else {
+            ret = -EINVAL;
+        }
+
+        if (ret) {
+            return ret;
+        }
+    } while (!stream_eof(s));
+
+    if (s->error) {
+        return s->error;
+    }
+
+    return o.p - o.start;
+}
@@ -22,68 +22,149 @@
 #include "atags.h"
 #include "config.h"
 #include "configfile.h"
+#include "delay.h"
+#include "extents.h"
+#include "fdt.h"
+#include "image.h"
+#include "layout.h"
+#include "load.h"
+#include "log.h"
+#include "mmu.h"
 #include "panic.h"
+#include "timer.h"
+#ifdef CONFIG_HOST
+#include "host/host.h"
+#endif
 
 FATFS fs;
 
-static size_t load_image(const TCHAR *name, void *load_at)
+/* whether [start, end) runs into size bytes at addr */
+static bool overlaps(u32 start, u32 end, u32 addr, size_t size)
+{
+    return size && start < addr + size && end > addr;
+}
+
+void main(u32 lowlevel_raw, u32 copy_raw)
 {
     FRESULT fr;
-    FIL f;
 
-    if (!config.quiet) {
-        printf("loading %s...", name);
-    }
+    timer_stamp("lowlevel_init", timer_raw_ticks(lowlevel_raw));
+    timer_stamp("bl2 copy", timer_raw_ticks(copy_raw));
 
-    fr = f_open(&f, name, FA_READ);
-    if (fr != FR_OK) {
-        panic("error opening %s: %d\n", name, (int)fr);
-    }
+    log_init();
+    mmu_init();
 
-    size_t size;
-    fr = f_read(&f, load_at, (8*1024*1024), &size); 
+    fr = f_mount(&fs, "", 1);
     if (fr != FR_OK) {
-        panic("error reading %s: %d\n", name, (int)fr);
+        panic("error mounting FAT: %d\n", (int)fr);
     }
+    timer_stamp("f_mount", timer_ticks());
+
+    read_configfile();
+    timer_stamp("read_configfile", timer_ticks());
 
-    f_close(&f);
+    /* quiet only silences the serial port, everything is still logged */
+    log_set_quiet(config.quiet);
 
-    if (!config.quiet) {
-        printf(" loaded %d bytes\n", size);
+    if (config.auto_address && !strlen(config.image)) {
+        layout_plan();
+        timer_stamp("layout_plan", timer_ticks());
     }
 
-    return size;
-}
+    if (config.baudrate && serial_setbrg(config.baudrate) != 0) {
+        panic("unable to set baudrate %d\n", config.baudrate);
+    }
 
-void main(void)
-{
-    FRESULT fr;
+    void *parm_at = (void *)PHYS_SDRAM_1 + 0x100;
 
-    fr = f_mount(&fs, "", 1);
-    if (fr != FR_OK) {
-        panic("error mounting FAT: %d\n", (int)fr);
+    if (config.extent_cache) {
+        extents_init();
     }
 
-    read_configfile();
+    if (strlen(config.image)) {
+        image_load(config.image);
+        timer_stamp(config.image, timer_ticks());
+    } else {
+        config.kernel_size = load_image(config.kernel,
+                                        (void *)config.kernel_address,
+                                        EXTENTS_KERNEL, &config.kernel_digest);
+        timer_stamp(config.kernel, timer_ticks());
+
+        if (strlen(config.initramfs)) {
+            void *initramfs_at = (void *)config.initramfs_address;
+            config.initramfs_size = load_image(config.initramfs, initramfs_at,
+                                               EXTENTS_INITRAMFS,
+                                               &config.initramfs_digest);
+            timer_stamp(config.initramfs, timer_ticks());
+        }
+
+        if (strlen(config.dtb)) {
+            config.dtb_size = load_image(config.dtb,
+                                         (void *)config.dtb_address, -1, NULL);
+            timer_stamp(config.dtb, timer_ticks());
+        }
+    }
 
-    void *exec_at = (void *)config.kernel_address;
-    void *parm_at = (void *)PHYS_SDRAM_1 + 0x100;
+    if (config.extent_cache) {
+        extents_commit();
+        timer_stamp("extents_commit", timer_ticks());
+    }
+
+    /* spare the kernel calibrate_delay(), unless told its lpj already */
+    if (config.kernel_hz && !config_cmdline_has("lpj=")) {
+        unsigned int lpj = delay_lpj(config.kernel_hz);
+        if (lpj) {
+            char opt[16];
+            snprintf(opt, sizeof(opt), "lpj=%u", lpj);
+            config_cmdline_append(opt);
+        }
+        timer_stamp("delay_lpj", timer_ticks());
+    }
 
-    load_image(config.kernel, exec_at);
+    if (config.dtb_size) {
+        u32 dtb_end = config.dtb_address + config.dtb_size + FDT_GROW;
+
+        if ((config.dtb_address < CFG_NANOBOOT_BASE
+                    && dtb_end > CFG_NANOBOOT_BASE)
+                || overlaps(config.dtb_address, dtb_end,
+                            config.initramfs_address, config.initramfs_size)
+                || overlaps(config.dtb_address, dtb_end,
+                            config.kernel_address, config.kernel_size)) {
+            panic("no room to grow the device tree at 0x%x\n",
+                  config.dtb_address);
+        }
+
+        int ret = setup_fdt((void *)config.dtb_address,
+                            config.dtb_size + FDT_GROW);
+        if (ret) {
+            panic("error setting up the device tree: %d\n", ret);
+        }
+
+        /* r2 points at the device tree instead of the ATAGs */
+        parm_at = (void *)config.dtb_address;
+        timer_stamp("setup_fdt", timer_ticks());
+    } else {
+        setup_atags(parm_at);
+        timer_stamp("setup_atags", timer_ticks());
+    }
 
-    if (strlen(config.initramfs)) {
-        void *initramfs_at = (void *)config.initramfs_address;
-        config.initramfs_size = load_image(config.initramfs, initramfs_at);
+    if (config.boot_timing) {
+        log_set_quiet(false);
+        timer_report();
+        log_set_quiet(config.quiet);
     }
 
-    setup_atags(parm_at);
-    
     void (*theKernel)(int zero, int arch, u32 params);
-    theKernel = (void (*)(int, int, u32))exec_at;
+    theKernel = (void (*)(int, int, u32))config.kernel_address;
 
-    if (!config.quiet) {
-        printf("Making jump to kernel...\n");
-    }
+    printf("Making jump to kernel...\n");
+
+    serial_flush();
+    mmu_disable();
 
+#ifdef CONFIG_HOST
+    host_boot((u32)theKernel, (u32)parm_at);
+#else
     theKernel(0, 1685, (u32)parm_at);
+#endif
 }
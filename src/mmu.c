@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Flat identity mapping made of 1 MB sections.  Both SDRAM banks are mapped
+ * write-back cacheable, everything else (iROM, SRAM and the peripherals) is
+ * left strongly ordered so register accesses behave exactly as they do with
+ * the MMU off.
+ */
+
+#include <asm/types.h>
+#include "config.h"
+#include "mmu.h"
+
+#ifdef CONFIG_MMU
+
+#define SECTION_SHIFT       20
+#define SECTION_SIZE        (1 << SECTION_SHIFT)
+
+#define PMD_TYPE_SECT       (2 << 0)
+#define PMD_BUFFERABLE      (1 << 2)
+#define PMD_CACHEABLE       (1 << 3)
+#define PMD_BIT4            (1 << 4)    /* must be set on ARM926 */
+#define PMD_AP_RW           (3 << 10)
+
+#define CR_M                (1 << 0)    /* MMU enable */
+#define CR_C                (1 << 2)    /* D-cache enable */
+#define CR_I                (1 << 12)   /* I-cache enable */
+
+/* domain 0 as client, so the section access bits are checked */
+#define DACR_CLIENT         1
+
+static u32 page_table[4096] __attribute__((aligned(16384)));
+
+static void map_sections(u32 base, u32 size, u32 flags)
+{
+    u32 i;
+
+    for (i = base >> SECTION_SHIFT; i < (base + size) >> SECTION_SHIFT; i++) {
+        page_table[i] = (i << SECTION_SHIFT) | flags;
+    }
+}
+
+void mmu_init(void)
+{
+    u32 cr;
+
+    for (u32 i = 0; i < 4096; i++) {
+        page_table[i] = (i << SECTION_SHIFT) | PMD_AP_RW | PMD_BIT4
+                      | PMD_TYPE_SECT;
+    }
+    map_sections(PHYS_SDRAM_1, PHYS_SDRAM_1_SIZE, PMD_AP_RW | PMD_CACHEABLE
+                 | PMD_BUFFERABLE | PMD_BIT4 | PMD_TYPE_SECT);
+    map_sections(PHYS_SDRAM_2, PHYS_SDRAM_2_SIZE, PMD_AP_RW | PMD_CACHEABLE
+                 | PMD_BUFFERABLE | PMD_BIT4 | PMD_TYPE_SECT);
+
+    asm volatile(
+        "mcr p15, 0, %0, c7, c10, 4\n"  /* drain write buffer */
+        "mcr p15, 0, %0, c8, c7, 0\n"   /* invalidate TLBs */
+        "mcr p15, 0, %1, c2, c0, 0\n"   /* translation table base */
+        "mcr p15, 0, %2, c3, c0, 0\n"   /* domain access control */
+        : : "r" (0), "r" (page_table), "r" (DACR_CLIENT) : "memory");
+
+    asm volatile("mrc p15, 0, %0, c1, c0, 0" : "=r" (cr));
+    cr |= CR_M | CR_C | CR_I;
+    asm volatile("mcr p15, 0, %0, c1, c0, 0" : : "r" (cr) : "memory");
+}
+
+/*
+ * The kernel expects to be entered with the MMU and D-cache off and its
+ * image in memory, so write back every dirty line before turning them off.
+ */
+void mmu_disable(void)
+{
+    u32 cr;
+
+    asm volatile(
+        "1: mrc p15, 0, r15, c7, c14, 3\n"  /* test, clean and invalidate */
+        "   bne 1b\n"
+        : : : "cc", "memory");
+
+    asm volatile("mrc p15, 0, %0, c1, c0, 0" : "=r" (cr));
+    cr &= ~(CR_M | CR_C);
+    asm volatile("mcr p15, 0, %0, c1, c0, 0" : : "r" (cr) : "memory");
+
+    asm volatile(
+        "mcr p15, 0, %0, c7, c5, 0\n"   /* invalidate I-cache */
+        "mcr p15, 0, %0, c7, c10, 4\n"  /* drain write buffer */
+        "mcr p15, 0, %0, c8, c7, 0\n"   /* invalidate TLBs */
+        : : "r" (0) : "memory");
+}
+
+/* write back [start, end) so a DMA master sees what the CPU wrote */
+void dcache_clean_range(u32 start, u32 end)
+{
+    start &= ~(CACHE_LINE_SIZE - 1);
+    for (; start < end; start += CACHE_LINE_SIZE) {
+        asm volatile("mcr p15, 0, %0, c7, c10, 1" : : "r" (start));
+    }
+    asm volatile("mcr p15, 0, %0, c7, c10, 4" : : "r" (0) : "memory");
+}
+
+/*
+ * Discard [start, end) so the CPU sees what a DMA master wrote.  Lines only
+ * partly inside the range are written back first, the bytes outside it
+ * belong to someone else.
+ */
+void dcache_inval_range(u32 start, u32 end)
+{
+    if (start & (CACHE_LINE_SIZE - 1)) {
+        start &= ~(CACHE_LINE_SIZE - 1);
+        asm volatile("mcr p15, 0, %0, c7, c14, 1" : : "r" (start));
+        start += CACHE_LINE_SIZE;
+    }
+
+    if (end & (CACHE_LINE_SIZE - 1)) {
+        end &= ~(CACHE_LINE_SIZE - 1);
+        asm volatile("mcr p15, 0, %0, c7, c14, 1" : : "r" (end));
+    }
+
+    for (; start < end; start += CACHE_LINE_SIZE) {
+        asm volatile("mcr p15, 0, %0, c7, c6, 1" : : "r" (start));
+    }
+    asm volatile("mcr p15, 0, %0, c7, c10, 4" : : "r" (0) : "memory");
+}
+
+#else
+
+void mmu_init(void)
+{
+}
+
+void mmu_disable(void)
+{
+}
+
+void dcache_clean_range(u32 start, u32 end)
+{
+}
+
+void dcache_inval_range(u32 start, u32 end)
+{
+}
+
+#endif /* CONFIG_MMU */
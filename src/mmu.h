@@ -0,0 +1,31 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __MMU_H
+#define __MMU_H
+
+#include <asm/types.h>
+
+#define CACHE_LINE_SIZE     32
+
+void mmu_init(void);
+void mmu_disable(void);
+
+void dcache_clean_range(u32 start, u32 end);
+void dcache_inval_range(u32 start, u32 end);
+
+#endif /* __MMU_H */
@@ -46,6 +46,11 @@ inline int isalnum(int c)
     return isalpha(c) || isdigit(c);
 }
 
+inline int isxdigit(int c)
+{
+    return isdigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
 inline int tolower(int c)
 {
     return isupper(c) ? c + 32 : c;
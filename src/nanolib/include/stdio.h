@@ -19,7 +19,7 @@
 #define _STDIO_H
 
 #include <stdarg.h>
-#include <stdio.h>
+#include <stddef.h>
 
 #include "serial.h"
 
@@ -30,6 +30,8 @@
 
 int printf (const char *, ...);
 int vprintf(const char *fmt, va_list va);
+int snprintf(char *str, size_t size, const char *fmt, ...);
+int vsnprintf(char *str, size_t size, const char *fmt, va_list va);
 
 #define putchar(c) serial_putc((char)c)
 #define puts(s) serial_puts(s)
@@ -16,16 +16,67 @@
  */
 
 #include <stddef.h>
+#include <stdint.h>
 
-void *memcpy(void *dest, void *src, size_t n)
+/*
+ * Once the destination is word aligned, co-aligned data is moved 32 bytes at
+ * a time with an 8 register ldm/stm pair.  A source at a different byte
+ * offset is read a word at a time and each destination word is merged from
+ * two neighbouring source words.
+ */
+void *memcpy(void *dest, const void *src, size_t n)
 {
-    unsigned char *dst8 = (unsigned char *)dest;
-    unsigned char *src8 = (unsigned char *)src;
+    unsigned char *d = dest;
+    const unsigned char *s = src;
+
+    if (n >= 8) {
+        while ((uintptr_t)d & 3) {
+            *d++ = *s++;
+            n--;
+        }
+
+        uint32_t *dw = (uint32_t *)d;
+        unsigned int shift = ((uintptr_t)s & 3) * 8;
+
+        if (!shift) {
+            const uint32_t *sw = (const uint32_t *)s;
+#ifdef __arm__
+            size_t blocks = n >> 5;
+            if (blocks) {
+                asm volatile(
+                    "1: ldmia %1!, {r3-r10}\n"
+                    "   stmia %0!, {r3-r10}\n"
+                    "   subs %2, %2, #1\n"
+                    "   bne 1b\n"
+                    : "+r" (dw), "+r" (sw), "+r" (blocks)
+                    :
+                    : "r3", "r4", "r5", "r6", "r7", "r8", "r9", "r10",
+                      "cc", "memory");
+                n &= 31;
+            }
+#endif
+            while (n >= 4) {
+                *dw++ = *sw++;
+                n -= 4;
+            }
+            s = (const unsigned char *)sw;
+        } else {
+            const uint32_t *sw = (const uint32_t *)((uintptr_t)s & ~3);
+            uint32_t cur = *sw++;
+            while (n >= 4) {
+                uint32_t next = *sw++;
+                *dw++ = (cur >> shift) | (next << (32 - shift));
+                cur = next;
+                n -= 4;
+            }
+            s = (const unsigned char *)(sw - 1) + shift / 8;
+        }
+        d = (unsigned char *)dw;
+    }
 
     while (n--) {
-        *dst8++ = *src8++;
+        *d++ = *s++;
     }
 
     return dest;
 }
-
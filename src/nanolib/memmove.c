@@ -16,28 +16,39 @@
  */
 
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 
 void *memmove(void *dest, const void *src, size_t n)
 {
-    const char *psrc = src;
-    char *pdest = dest;
+    const unsigned char *psrc = src;
+    unsigned char *pdest = dest;
 
-    if (src == dest) {
-        return dest;
+    /* memcpy only ever reads ahead of where it writes */
+    if (pdest <= psrc || pdest >= psrc + n) {
+        return memcpy(dest, src, n);
     }
 
-    if (src < dest) {
-        psrc = psrc + n - 1;
-        dest = pdest + n - 1;
+    psrc += n;
+    pdest += n;
 
-        while (n--) {
-            *pdest-- = *psrc--;
+    if (!(((uintptr_t)psrc ^ (uintptr_t)pdest) & 3)) {
+        while (n && ((uintptr_t)pdest & 3)) {
+            *--pdest = *--psrc;
+            n--;
         }
-    } else {
-        while (n--) {
-            *pdest++ = *psrc++;
+
+        while (n >= 4) {
+            pdest -= 4;
+            psrc -= 4;
+            *(uint32_t *)pdest = *(const uint32_t *)psrc;
+            n -= 4;
         }
     }
 
+    while (n--) {
+        *--pdest = *--psrc;
+    }
+
     return dest;
 }
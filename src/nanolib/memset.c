@@ -16,14 +16,52 @@
  */
 
 #include <stddef.h>
+#include <stdint.h>
 
 void *memset(void *s, int c, size_t n)
 {
     unsigned char *p = (unsigned char *)s;
 
+    if (n >= 8) {
+        uint32_t v = (unsigned char)c * 0x01010101u;
+
+        while ((uintptr_t)p & 3) {
+            *p++ = (unsigned char)c;
+            n--;
+        }
+
+        uint32_t *pw = (uint32_t *)p;
+#ifdef __arm__
+        size_t blocks = n >> 5;
+        if (blocks) {
+            asm volatile(
+                "   mov r3, %2\n"
+                "   mov r4, %2\n"
+                "   mov r5, %2\n"
+                "   mov r6, %2\n"
+                "   mov r7, %2\n"
+                "   mov r8, %2\n"
+                "   mov r9, %2\n"
+                "   mov r10, %2\n"
+                "1: stmia %0!, {r3-r10}\n"
+                "   subs %1, %1, #1\n"
+                "   bne 1b\n"
+                : "+r" (pw), "+r" (blocks)
+                : "r" (v)
+                : "r3", "r4", "r5", "r6", "r7", "r8", "r9", "r10",
+                  "cc", "memory");
+            n &= 31;
+        }
+#endif
+        while (n >= 4) {
+            *pw++ = v;
+            n -= 4;
+        }
+        p = (unsigned char *)pw;
+    }
+
     while (n--)
         *p++ = (unsigned char)c;
 
     return s;
 }
-
@@ -21,8 +21,10 @@
 int printf(const char *fmt, ...)
 {
     va_list va;
+    int ret;
+
     va_start(va, fmt);
-    vprintf(fmt, va);
+    ret = vprintf(fmt, va);
     va_end(va);
-    return 0;
+    return ret;
 }
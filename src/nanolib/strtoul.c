@@ -70,8 +70,28 @@ strtoul(const char *nptr, char **endptr, int base)
     if (base == 0)
         base = c == '0' ? 8 : 10;
 
-    cutoff = ULONG_MAX / (unsigned long)base;
-    cutlim = ULONG_MAX % (unsigned long)base;
+    /*
+     * There is no divide instruction on the ARM926; spell out the common
+     * bases so their cutoffs fold to constants instead of libgcc calls.
+     */
+    switch (base) {
+    case 8:
+        cutoff = ULONG_MAX / 8;
+        cutlim = ULONG_MAX % 8;
+        break;
+    case 10:
+        cutoff = ULONG_MAX / 10;
+        cutlim = ULONG_MAX % 10;
+        break;
+    case 16:
+        cutoff = ULONG_MAX / 16;
+        cutlim = ULONG_MAX % 16;
+        break;
+    default:
+        cutoff = ULONG_MAX / (unsigned long)base;
+        cutlim = ULONG_MAX % (unsigned long)base;
+        break;
+    }
     for (acc = 0, any = 0;; c = (unsigned char) *s++) {
         if (isdigit(c))
             c -= '0';
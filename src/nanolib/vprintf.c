@@ -17,115 +17,233 @@
 
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
+#include <string.h>
+#include "log.h"
 
-static int itoa(int value, char *s, unsigned int radix, bool uppercase, bool is_signed)
+/*
+ * Formatted output goes into a buffer.  For vsnprintf() that is the caller's
+ * buffer and anything past its end is only counted; for vprintf() it is a
+ * small buffer on the stack that is handed to log_write() whenever it fills
+ * up, so the log and the UART are fed in runs rather than a byte at a time.
+ */
+struct out {
+    char *buf;
+    size_t size;
+    size_t len;
+    int count;
+    void (*flush)(const char *buf, size_t len);
+};
+
+static void out_putc(struct out *o, char c)
 {
-    unsigned int n;
-    char *p;
-    char digit;
-    int digits = 0;
-    int negative = 0;
-
-    if (value == 0) {
-        s[0] = '0';
-        s[1] = 0;
-        return 1;
+    o->count++;
+    if (o->len < o->size) {
+        o->buf[o->len++] = c;
+        if (o->len == o->size && o->flush) {
+            o->flush(o->buf, o->len);
+            o->len = 0;
+        }
     }
+}
 
-    if (is_signed && radix == 10 && value < 0) {
-        value = -value;
-        negative = 1;
-        digits += 1;
+static void out_puts(struct out *o, const char *s)
+{
+    while (*s) {
+        out_putc(o, *s++);
     }
+}
 
-    n = value;
-    while (n) {
-        n /= radix;
-        digits += 1;
+static void out_pad(struct out *o, char c, unsigned int n)
+{
+    while (n--) {
+        out_putc(o, c);
     }
+}
 
-    p = s + digits;
-    *p-- = 0;
-
-    n = value;
-    while (n) {
-        digit = (n % radix);
-        n /= radix;
-        digit += (digit <= 9) ? '0' : (uppercase ? 'A' : 'a') - 10;
-        *p-- = digit;
+/*
+ * Write the digits of n backwards, ending at end, and return a pointer to
+ * the first one.  The ARM926 has no divide instruction, so hex is done with
+ * shifts and decimal with a multiply by the reciprocal of 10, which gives the
+ * exact quotient for every 32-bit value.
+ */
+static char *utoa(unsigned int n, char *end, unsigned int radix, bool uppercase)
+{
+    const char *digits = uppercase ? "0123456789ABCDEF" : "0123456789abcdef";
+    unsigned int q;
+    char *p = end;
+
+    *p = '\0';
+
+    if (radix == 16) {
+        do {
+            *--p = digits[n & 0xf];
+            n >>= 4;
+        } while (n);
+        return p;
     }
 
-    if (negative) {
-        *p = '-';
-    }
+    do {
+        q = ((unsigned long long)n * 0xcccccccd) >> 35;
+        *--p = '0' + (n - q * 10);
+        n = q;
+    } while (n);
 
-    return digits;
+    return p;
 }
 
-int vprintf(const char *fmt, va_list va)
+/*
+ * Output prefix and s within a field of width characters, padded with spaces
+ * on either side or with zeros between the prefix and s.
+ */
+static void field(struct out *o, const char *prefix, const char *s,
+                  unsigned int width, char fill, bool left)
+{
+    unsigned int len = strlen(prefix) + strlen(s);
+    unsigned int n = width > len ? width - len : 0;
+
+    if (!left && fill == ' ') {
+        out_pad(o, ' ', n);
+    }
+    out_puts(o, prefix);
+    if (!left && fill == '0') {
+        out_pad(o, '0', n);
+    }
+    out_puts(o, s);
+    if (left) {
+        out_pad(o, ' ', n);
+    }
+}
+
+static void format(struct out *o, const char *fmt, va_list va)
 {
     char buf[12];
+    char *end = buf + sizeof(buf) - 1;
+    const char *prefix;
+    const char *s;
     char c;
-    char zero_pad;
-    unsigned int len;
+    char fill;
+    bool left;
+    bool is_long;
+    unsigned int width;
+    unsigned int n;
+    int i;
 
     while ((c = *fmt++)) {
         if (c != '%') {
-            fputc(c, stdout);
-            if (c == '\n')
-                fputc('\r', stdout);
+            out_putc(o, c);
             continue;
         }
 
         c = *fmt++;
 
-        zero_pad = 0;
-        if (c == '0') {
-            c = *fmt++;
-            if (c == '\0')
-                return 0;
-            while (c >= '0' && c <= '9') {
-                zero_pad *= 10;
-                zero_pad += c - '0';
-                c = *fmt++;
+        fill = ' ';
+        left = false;
+        while (c == '-' || c == '0') {
+            if (c == '-') {
+                left = true;
+            } else {
+                fill = '0';
             }
+            c = *fmt++;
         }
 
+        width = 0;
+        while (c >= '0' && c <= '9') {
+            width = width * 10 + c - '0';
+            c = *fmt++;
+        }
+
+        is_long = false;
+        if (c == 'l') {
+            is_long = true;
+            c = *fmt++;
+        }
+
+        prefix = "";
         switch (c) {
             case 0:
-                return 0;
+                return;
 
-            case 'u':
             case 'd':
-                len = itoa(va_arg(va, int), buf, 10, 0, (c=='d'));
-                while (zero_pad-- > len)
-                    fputc('0', stdout);
-                fputs(buf, stdout);
+                i = is_long ? (int)va_arg(va, long) : va_arg(va, int);
+                n = i;
+                if (i < 0) {
+                    prefix = "-";
+                    n = -n;
+                }
+                s = utoa(n, end, 10, false);
+                break;
+
+            case 'u':
+                n = is_long ? va_arg(va, unsigned long)
+                            : va_arg(va, unsigned int);
+                s = utoa(n, end, 10, false);
                 break;
 
             case 'x':
             case 'X':
-                len = itoa(va_arg(va, int), buf, 16, (c=='X'), 0);
-                while (zero_pad-- > len)
-                    fputc('0', stdout);
-                fputs(buf, stdout);
+                n = is_long ? va_arg(va, unsigned long)
+                            : va_arg(va, unsigned int);
+                s = utoa(n, end, 16, (c=='X'));
+                break;
+
+            case 'p':
+                n = (unsigned long)va_arg(va, void *);
+                s = utoa(n, end, 16, false);
+                prefix = "0x";
+                if (!width) {
+                    width = 10;
+                    fill = '0';
+                }
                 break;
 
             case 'c':
-                fputc((char)(va_arg(va, int)), stdout);
+                buf[0] = (char)va_arg(va, int);
+                buf[1] = '\0';
+                s = buf;
                 break;
 
             case 's':
-                fputs(va_arg(va, char *), stdout);
+                s = va_arg(va, char *);
                 break;
 
             default:
-                fputc(c, stdout);
-                if (c == '\n')
-                    fputc('\r', stdout);
-                break;
+                out_putc(o, c);
+                continue;
         }
+
+        field(o, prefix, s, width, fill, left);
+    }
+}
+
+int vsnprintf(char *str, size_t size, const char *fmt, va_list va)
+{
+    struct out o = {
+        .buf = str,
+        .size = size ? size - 1 : 0,
+    };
+
+    format(&o, fmt, va);
+    if (size) {
+        str[o.len] = '\0';
+    }
+    return o.count;
+}
+
+int vprintf(const char *fmt, va_list va)
+{
+    char buf[64];
+    struct out o = {
+        .buf = buf,
+        .size = sizeof(buf),
+        .flush = log_write,
+    };
+
+    format(&o, fmt, va);
+    if (o.len) {
+        log_write(buf, o.len);
     }
-    return 0;
+    return o.count;
 }
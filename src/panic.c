@@ -19,13 +19,20 @@
 #include <stdio.h>
 #include "s3c2450.h"
 #include "delay.h"
+#include "log.h"
+#include "serial.h"
 
 void panic(const char *fmt, ...)
 {
     va_list va;
+
+    /* errors always make it to the serial port */
+    log_set_quiet(false);
+
     va_start(va, fmt);
     vprintf(fmt, va);
     va_end(va);
+    serial_flush();
 
     /* flash the LED 3 times a second */
     delay_init();
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * SHA-256 (FIPS 180-4)
+ *
+ * The compression function is laid out for the ARM926: the message schedule
+ * is kept as a rolling 16 word window rather than 64 words, and the rounds
+ * are unrolled eight at a time with the working variables renamed instead
+ * of shuffled, so a, ..., h stay in registers and the rotates fold into the
+ * barrel shifter of the instructions that use them.
+ */
+
+#include <asm/types.h>
+#include <stddef.h>
+#include <string.h>
+#include "sha256.h"
+
+static const u32 K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define ROR(x, n)   (((x) >> (n)) | ((x) << (32 - (n))))
+
+#define S0(x)       (ROR(x, 2) ^ ROR(x, 13) ^ ROR(x, 22))
+#define S1(x)       (ROR(x, 6) ^ ROR(x, 11) ^ ROR(x, 25))
+#define s0(x)       (ROR(x, 7) ^ ROR(x, 18) ^ ((x) >> 3))
+#define s1(x)       (ROR(x, 17) ^ ROR(x, 19) ^ ((x) >> 10))
+
+#define CH(e, f, g)     ((g) ^ ((e) & ((f) ^ (g))))
+#define MAJ(a, b, c)    (((a) & (b)) | ((c) & ((a) | (b))))
+
+/* schedule word i in place of word i - 16 */
+#define W(i)        w[(i) & 15]
+#define SCHED(i)    (W(i) += s1(W((i) - 2)) + W((i) - 7) + s0(W((i) - 15)))
+
+#define ROUND(a, b, c, d, e, f, g, h, i, wi) do { \
+        t = (h) + S1(e) + CH(e, f, g) + K[i] + (wi); \
+        (d) += t; \
+        (h) = t + S0(a) + MAJ(a, b, c); \
+    } while (0)
+
+#define ROUNDS8(i, WI) do { \
+        ROUND(a, b, c, d, e, f, g, h, (i) + 0, WI((i) + 0)); \
+        ROUND(h, a, b, c, d, e, f, g, (i) + 1, WI((i) + 1)); \
+        ROUND(g, h, a, b, c, d, e, f, (i) + 2, WI((i) + 2)); \
+        ROUND(f, g, h, a, b, c, d, e, (i) + 3, WI((i) + 3)); \
+        ROUND(e, f, g, h, a, b, c, d, (i) + 4, WI((i) + 4)); \
+        ROUND(d, e, f, g, h, a, b, c, (i) + 5, WI((i) + 5)); \
+        ROUND(c, d, e, f, g, h, a, b, (i) + 6, WI((i) + 6)); \
+        ROUND(b, c, d, e, f, g, h, a, (i) + 7, WI((i) + 7)); \
+    } while (0)
+
+static inline u32 load_be32(const u8 *p)
+{
+    return (u32)p[0] << 24 | (u32)p[1] << 16 | (u32)p[2] << 8 | p[3];
+}
+
+static inline void store_be32(u8 *p, u32 v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static void sha256_block(u32 *state, const u8 *p)
+{
+    u32 a, b, c, d, e, f, g, h, t;
+    u32 w[16];
+    int i;
+
+    for (i = 0; i < 16; i++) {
+        w[i] = load_be32(p + i * 4);
+    }
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+    f = state[5];
+    g = state[6];
+    h = state[7];
+
+    for (i = 0; i < 16; i += 8) {
+        ROUNDS8(i, W);
+    }
+    for (; i < 64; i += 8) {
+        ROUNDS8(i, SCHED);
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+void sha256_init(struct sha256_ctx *ctx)
+{
+    ctx->state[0] = 0x6a09e667;
+    ctx->state[1] = 0xbb67ae85;
+    ctx->state[2] = 0x3c6ef372;
+    ctx->state[3] = 0xa54ff53a;
+    ctx->state[4] = 0x510e527f;
+    ctx->state[5] = 0x9b05688c;
+    ctx->state[6] = 0x1f83d9ab;
+    ctx->state[7] = 0x5be0cd19;
+    ctx->count = 0;
+}
+
+void sha256_update(struct sha256_ctx *ctx, const void *data, size_t len)
+{
+    const u8 *p = data;
+    size_t have = ctx->count & 63, n;
+
+    ctx->count += len;
+
+    if (have) {
+        n = 64 - have < len ? 64 - have : len;
+        memcpy(ctx->buf + have, p, n);
+        p += n;
+        len -= n;
+        if (have + n < 64) {
+            return;
+        }
+        sha256_block(ctx->state, ctx->buf);
+    }
+
+    /* whole blocks are hashed where they are, no copying */
+    while (len >= 64) {
+        sha256_block(ctx->state, p);
+        p += 64;
+        len -= 64;
+    }
+
+    memcpy(ctx->buf, p, len);
+}
+
+void sha256_final(struct sha256_ctx *ctx, u8 digest[SHA256_DIGEST_SIZE])
+{
+    size_t have = ctx->count & 63;
+    u64 bits = ctx->count << 3;
+    int i;
+
+    ctx->buf[have++] = 0x80;
+    if (have > 56) {
+        memset(ctx->buf + have, 0, 64 - have);
+        sha256_block(ctx->state, ctx->buf);
+        have = 0;
+    }
+    memset(ctx->buf + have, 0, 56 - have);
+    store_be32(ctx->buf + 56, bits >> 32);
+    store_be32(ctx->buf + 60, bits);
+    sha256_block(ctx->state, ctx->buf);
+
+    for (i = 0; i < 8; i++) {
+        store_be32(digest + i * 4, ctx->state[i]);
+    }
+}
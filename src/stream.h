@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __STREAM_H
+#define __STREAM_H
+
+#include <asm/types.h>
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * Input for the decompressors.  Bytes are taken from p up to end; when they
+ * run out refill() is asked for more, which returns the number of bytes it
+ * made available, 0 at the end of the input or a negative error, which it
+ * also leaves in error.
+ */
+struct stream {
+    const u8 *p;
+    const u8 *end;
+    int (*refill)(struct stream *s);
+    void *priv;
+    int error;
+};
+
+/* the next byte, or -1 at the end of the input or on error */
+static inline int stream_getc(struct stream *s)
+{
+    if (s->p == s->end && s->refill(s) <= 0) {
+        return -1;
+    }
+    return *s->p++;
+}
+
+/* true once all input has been consumed */
+static inline int stream_eof(struct stream *s)
+{
+    return s->p == s->end && s->refill(s) <= 0;
+}
+
+/* copy up to n bytes to buf, or skip them if buf is NULL */
+static inline size_t stream_read(struct stream *s, void *buf, size_t n)
+{
+    size_t done = 0, len;
+
+    while (done < n) {
+        if (s->p == s->end && s->refill(s) <= 0) {
+            break;
+        }
+        len = s->end - s->p;
+        if (len > n - done) {
+            len = n - done;
+        }
+        if (buf) {
+            memcpy((u8 *)buf + done, s->p, len);
+        }
+        s->p += len;
+        done += len;
+    }
+
+    return done;
+}
+
+#endif /* __STREAM_H */
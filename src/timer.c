@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Free running boot timer on PWM timer 0, started by lowlevel_init at
+ * PCLK/256/16.  The hardware counter is only 16 bits wide, so wraps are
+ * counted in software; timer_ticks() has to be called at least once per
+ * wrap period (about 4 seconds) to keep the count monotonic.  That is the
+ * slowest the timer can run, so the card wait loop and the image loader
+ * call it as they go.
+ */
+
+#include <asm/types.h>
+#include <stdio.h>
+#include "s3c2450.h"
+#include "clock.h"
+#include "timer.h"
+
+#define TIMER_PRESCALE      256
+#define TIMER_DIVIDER       16
+
+#define TIMER_STAMPS_MAX    16
+
+struct timer_stamp {
+    const char *name;
+    u32 ticks;
+};
+
+static struct timer_stamp stamps[TIMER_STAMPS_MAX];
+static int nstamps;
+
+#ifndef CONFIG_HOST
+static u32 last_raw = 0xffff;
+static u32 wrap_ticks;
+
+/* ticks elapsed since lowlevel_init started the timer */
+u32 timer_ticks(void)
+{
+    u32 raw = TCNTO0_REG & 0xffff;
+
+    if (raw > last_raw) {
+        wrap_ticks += 0x10000;
+    }
+    last_raw = raw;
+
+    return wrap_ticks + (0xffff - raw);
+}
+
+/* convert a counter value sampled before main() ran, assuming no wrap */
+u32 timer_raw_ticks(u32 raw)
+{
+    return 0xffff - (raw & 0xffff);
+}
+
+unsigned int timer_rate(void)
+{
+    return clock_get_pclk() / (TIMER_PRESCALE * TIMER_DIVIDER);
+}
+
+u32 timer_ticks_to_us(u32 ticks)
+{
+    return (u64)ticks * 1000000 / timer_rate();
+}
+#endif /* CONFIG_HOST */
+
+/* record the end of a boot phase */
+void timer_stamp(const char *name, u32 ticks)
+{
+    if (nstamps < TIMER_STAMPS_MAX) {
+        stamps[nstamps].name = name;
+        stamps[nstamps].ticks = ticks;
+        nstamps++;
+    }
+}
+
+void timer_report(void)
+{
+    u32 prev = 0;
+    int i;
+
+    printf("boot timing:\n");
+    for (i = 0; i < nstamps; i++) {
+        printf("  %-16s %8u us\n", stamps[i].name,
+               timer_ticks_to_us(stamps[i].ticks - prev));
+        prev = stamps[i].ticks;
+    }
+    printf("  %-16s %8u us\n", "total", timer_ticks_to_us(prev));
+}
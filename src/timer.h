@@ -0,0 +1,31 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __TIMER_H
+#define __TIMER_H
+
+#include <asm/types.h>
+
+u32 timer_ticks(void);
+u32 timer_raw_ticks(u32 raw);
+unsigned int timer_rate(void);
+u32 timer_ticks_to_us(u32 ticks);
+
+void timer_stamp(const char *name, u32 ticks);
+void timer_report(void);
+
+#endif /* __TIMER_H */
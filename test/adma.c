@@ -0,0 +1,214 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Build ADMA2 descriptor tables with hsmmc_adma_build() for transfers that
+ * start and end on either side of the per-descriptor limit, and hand each
+ * table to a stand-in for the controller's ADMA engine.  It walks the table
+ * the way the hardware does and copies a card's worth of data to the
+ * addresses it finds, which must end up covering exactly the buffer asked
+ * for.  The rest of hsmmc.c is linked in but never run.
+ *
+ *   make test
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+
+#include "s3c2450.h"
+#include "clock.h"
+#include "hsmmc.h"
+#include "mmu.h"
+#include "serial.h"
+#include "timer.h"
+
+/* bus address the simulated SDRAM starts at */
+#define SDRAM_BASE  0x30000000
+#define SDRAM_SIZE  (HSMMC_MAX_BLKCNT * 512 + 4 * HSMMC_ADMA_MAXLEN)
+
+static u8 *sdram;
+static u8 *card;
+static struct hsmmc_adma_desc table[HSMMC_ADMA_DESCS + 1];
+static int failures;
+
+unsigned int clock_get_hsmmc(void)
+{
+    return 0;
+}
+
+void dcache_clean_range(u32 start, u32 end)
+{
+}
+
+void dcache_inval_range(u32 start, u32 end)
+{
+}
+
+void serial_poll(void)
+{
+}
+
+u32 timer_ticks(void)
+{
+    return 0;
+}
+
+/*
+ * Follow the table from its first entry until an END attribute, moving the
+ * card data to each descriptor's address.  Returns the number of
+ * descriptors consumed, or -1 after reporting a table the controller would
+ * reject or that strays outside SDRAM.
+ */
+static int adma_run(int max, u32 len)
+{
+    u32 done = 0;
+
+    for (int i = 0; i < max; i++) {
+        u32 attr = table[i].attr;
+        u32 addr = table[i].addr;
+        u32 n = attr >> 16 ? attr >> 16 : 0x10000;
+
+        if (!(attr & HM_ADMA_VALID)
+                || (attr & (3 << 4)) != HM_ADMA_ACT_TRAN) {
+            fprintf(stderr, "  descriptor %d: bad attributes 0x%x\n", i,
+                    attr & 0xffff);
+            return -1;
+        }
+        if (n > HSMMC_ADMA_MAXLEN || (n | addr) & 3) {
+            fprintf(stderr, "  descriptor %d: bad length %u or address "
+                    "0x%x\n", i, n, addr);
+            return -1;
+        }
+        if (addr < SDRAM_BASE || addr - SDRAM_BASE + n > SDRAM_SIZE
+                || done + n > len) {
+            fprintf(stderr, "  descriptor %d: 0x%x+%u is out of range\n", i,
+                    addr, n);
+            return -1;
+        }
+
+        memcpy(sdram + addr - SDRAM_BASE, card + done, n);
+        done += n;
+
+        if (attr & HM_ADMA_END) {
+            if (done != len) {
+                fprintf(stderr, "  table ends after %u of %u bytes\n", done,
+                        len);
+                return -1;
+            }
+            return i + 1;
+        }
+    }
+
+    fprintf(stderr, "  no END in %d descriptors\n", max);
+    return -1;
+}
+
+static void test_transfer(u32 offset, u32 len)
+{
+    u32 addr = SDRAM_BASE + offset;
+    int n, want = (len + HSMMC_ADMA_MAXLEN - 1) / HSMMC_ADMA_MAXLEN;
+
+    memset(table, 0xff, sizeof(table));
+    memset(sdram, 0xa5, SDRAM_SIZE);
+
+    n = hsmmc_adma_build(table, HSMMC_ADMA_DESCS, addr, len);
+    if (n != want || (len && adma_run(n, len) != n)) {
+        fprintf(stderr, "0x%x+%u: built %d descriptors, expected %d\n", addr,
+                len, n, want);
+        failures++;
+        return;
+    }
+
+    /* the buffer holds the card data, and nothing around it was touched */
+    for (u32 i = 0; i < SDRAM_SIZE; i++) {
+        u8 expect = i >= offset && i - offset < len ? card[i - offset] : 0xa5;
+
+        if (sdram[i] != expect) {
+            fprintf(stderr, "0x%x+%u: wrong byte at 0x%x\n", addr, len,
+                    SDRAM_BASE + i);
+            failures++;
+            return;
+        }
+    }
+}
+
+static void test_error(const char *what, int max, u32 addr, u32 len, int want)
+{
+    int n = hsmmc_adma_build(table, max, addr, len);
+
+    if (n != want) {
+        fprintf(stderr, "%s: returned %d, expected %d\n", what, n, want);
+        failures++;
+    }
+}
+
+int main(void)
+{
+    static const u32 offsets[] = {
+        0, 4, 512, HSMMC_ADMA_MAXLEN - 4, HSMMC_ADMA_MAXLEN,
+        HSMMC_ADMA_MAXLEN + 4, 3 * HSMMC_ADMA_MAXLEN - 512,
+    };
+    static const u32 lens[] = {
+        0, 4, 512, HSMMC_ADMA_MAXLEN - 512, HSMMC_ADMA_MAXLEN - 4,
+        HSMMC_ADMA_MAXLEN, HSMMC_ADMA_MAXLEN + 4, HSMMC_ADMA_MAXLEN + 512,
+        2 * HSMMC_ADMA_MAXLEN, 2 * HSMMC_ADMA_MAXLEN + 4,
+        7 * HSMMC_ADMA_MAXLEN - 4, 1024 * 1024 + 512,
+        (HSMMC_MAX_BLKCNT - 1) * 512, HSMMC_MAX_BLKCNT * 512,
+    };
+
+    sdram = malloc(SDRAM_SIZE);
+    card = malloc(SDRAM_SIZE);
+    if (!sdram || !card) {
+        fprintf(stderr, "adma: out of memory\n");
+        return 1;
+    }
+    for (u32 i = 0; i < SDRAM_SIZE; i++) {
+        card[i] = i * 7 + (i >> 9);
+    }
+
+    for (size_t o = 0; o < sizeof(offsets) / sizeof(offsets[0]); o++) {
+        for (size_t l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) {
+            test_transfer(offsets[o], lens[l]);
+        }
+    }
+
+    test_error("unaligned address", HSMMC_ADMA_DESCS, SDRAM_BASE + 2, 512,
+               -EINVAL);
+    test_error("unaligned length", HSMMC_ADMA_DESCS, SDRAM_BASE, 510,
+               -EINVAL);
+    test_error("table one short", 2, SDRAM_BASE, 2 * HSMMC_ADMA_MAXLEN + 4,
+               -ENOSPC);
+    test_error("table just fits", 3, SDRAM_BASE, 2 * HSMMC_ADMA_MAXLEN + 4,
+               3);
+    test_error("largest transfer", HSMMC_ADMA_DESCS, SDRAM_BASE,
+               HSMMC_MAX_BLKCNT * 512, HSMMC_ADMA_DESCS);
+
+    if (failures) {
+        fprintf(stderr, "adma: %d failures\n", failures);
+        return 1;
+    }
+
+    printf("adma: ok\n");
+    return 0;
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Throughput of the loader's CRC-32 and SHA-256 over a buffer the size of a
+ * typical kernel, fed in the odd-sized pieces read_chunks() can produce,
+ * next to a byte-at-a-time CRC-32 for reference.  Both are first checked
+ * against known digests, and piecewise hashing against one-shot hashing.
+ *
+ *   make bench && build/test/bench_digest
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef uint8_t u8;
+typedef uint32_t u32;
+typedef unsigned long long u64;
+
+#include "crc32.h"
+#include "sha256.h"
+
+#define SIZE        (4 * 1024 * 1024)
+#define ROUNDS      10
+
+static u32 byte_table[256];
+
+static u32 byte_crc32(u32 crc, const u8 *p, size_t len)
+{
+    crc = ~crc;
+    while (len--) {
+        crc = byte_table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, double start)
+{
+    double t = now() - start;
+
+    printf("  %-22s %7.0f MB/s\n", name, (double)ROUNDS * SIZE / 1e6 / t);
+}
+
+int main(void)
+{
+    static const u8 abc_sha256[SHA256_DIGEST_SIZE] = {
+        0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+        0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+        0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+        0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad,
+    };
+    struct sha256_ctx ctx;
+    u8 digest[SHA256_DIGEST_SIZE], whole[SHA256_DIGEST_SIZE];
+    u32 crc, piecewise, seed = 1;
+    size_t off, n;
+    double t;
+    u8 *buf;
+
+    for (u32 i = 0; i < 256; i++) {
+        u32 c = i;
+
+        for (int k = 0; k < 8; k++) {
+            c = c & 1 ? 0xedb88320 ^ (c >> 1) : c >> 1;
+        }
+        byte_table[i] = c;
+    }
+
+    buf = malloc(SIZE);
+    if (!buf) {
+        fprintf(stderr, "bench_digest: out of memory\n");
+        return 1;
+    }
+    for (size_t i = 0; i < SIZE; i++) {
+        seed = seed * 1103515245 + 12345;
+        buf[i] = seed >> 16;
+    }
+
+    sha256_init(&ctx);
+    sha256_update(&ctx, "abc", 3);
+    sha256_final(&ctx, digest);
+    if (crc32(0, "123456789", 9) != 0xcbf43926
+            || memcmp(digest, abc_sha256, sizeof(digest))) {
+        fprintf(stderr, "bench_digest: wrong digest of a test vector\n");
+        return 1;
+    }
+
+    crc = crc32(0, buf, SIZE);
+    sha256_init(&ctx);
+    sha256_update(&ctx, buf, SIZE);
+    sha256_final(&ctx, whole);
+
+    piecewise = 0;
+    sha256_init(&ctx);
+    for (off = 0, n = 1; off < SIZE; off += n, n = n * 7 % 4099 + 1) {
+        if (n > SIZE - off) {
+            n = SIZE - off;
+        }
+        piecewise = crc32(piecewise, buf + off, n);
+        sha256_update(&ctx, buf + off, n);
+    }
+    sha256_final(&ctx, digest);
+    if (crc != byte_crc32(0, buf, SIZE) || piecewise != crc
+            || memcmp(digest, whole, sizeof(digest))) {
+        fprintf(stderr, "bench_digest: piecewise digest differs\n");
+        return 1;
+    }
+
+    printf("%d MiB, digests agree\n", SIZE >> 20);
+
+    t = now();
+    for (int i = 0; i < ROUNDS; i++) {
+        crc = byte_crc32(crc, buf, SIZE);
+    }
+    report("crc32, byte at a time", t);
+
+    t = now();
+    for (int i = 0; i < ROUNDS; i++) {
+        crc = crc32(crc, buf, SIZE);
+    }
+    report("crc32", t);
+
+    t = now();
+    for (int i = 0; i < ROUNDS; i++) {
+        sha256_init(&ctx);
+        sha256_update(&ctx, buf, SIZE);
+        sha256_final(&ctx, digest);
+    }
+    report("sha256", t);
+
+    return crc == 0 && digest[0] == 0;
+}
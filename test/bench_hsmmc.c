@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Count the controller register accesses hsmmc.c makes for reads of
+ * various sizes, against the register model in hsmmc_model.c.  On the board
+ * each one is an uncached bus cycle, and while they are being made the CPU
+ * does nothing else, so these counts rather than host time are what show
+ * the cost of a transfer.  Status polls depend on how long the card takes
+ * and are shown separately.
+ *
+ *   make bench && build/test/bench_hsmmc
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+
+#include "hsmmc.h"
+#include "hsmmc_model.h"
+
+#define MAX_BLOCKS  2048
+
+/* the model DMAs to 32-bit addresses, which static data has */
+static u32 buf[MAX_BLOCKS * 128];
+static u8 card[MAX_BLOCKS * 512];
+
+int main(void)
+{
+    static const u32 counts[] = { 1, 8, 64, 256, MAX_BLOCKS };
+    struct model_card sdhc = {
+        .data = card, .blocks = MAX_BLOCKS, .high_capacity = true,
+    };
+    int ret;
+
+    alarm(60);
+
+    model_reset(&sdhc);
+    ret = hsmmc_init();
+    printf("init: %lu reads, %lu writes, %lu commands\n",
+           model_stats.reads - model_stats.polls, model_stats.writes,
+           model_stats.commands);
+    if (ret) {
+        fprintf(stderr, "init returned %d\n", ret);
+        return 1;
+    }
+
+    printf("%8s %10s %10s %10s %12s\n", "blocks", "reads", "writes", "polls",
+           "per block");
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        unsigned long accesses;
+
+        model_stats = (struct model_stats){ 0 };
+        ret = hsmmc_read_blocks(0, counts[i], buf);
+        if (ret || model_errors()) {
+            fprintf(stderr, "read of %u blocks failed\n", counts[i]);
+            return 1;
+        }
+
+        accesses = model_stats.reads - model_stats.polls + model_stats.writes;
+        printf("%8u %10lu %10lu %10lu %12.2f\n", counts[i],
+               model_stats.reads - model_stats.polls, model_stats.writes,
+               model_stats.polls, (double)accesses / counts[i]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Compare loading an image as it is with loading a compressed copy of it.
+ * The compressed file is decoded with the same lz4 or gzip code the loader
+ * uses, fed in 128 KiB pieces as load.c stages them, and checked against
+ * the original.  Card reads are modelled at a fixed rate and, as on the
+ * board, overlap decoding one stage behind.  The decode time measured here
+ * can be scaled up by how much slower the board's CPU is than the host's.
+ *
+ *   make bench && build/test/bench_load [-b MB/s] [-c slowdown] raw raw.lz4
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef uint8_t u8;
+typedef uint32_t u32;
+
+#include "gunzip.h"
+#include "lz4.h"
+
+#define STAGE_HALF  (128 * 1024)
+#define ROUNDS      5
+
+static const char *argv0;
+
+struct input {
+    const u8 *p;
+    const u8 *end;
+};
+
+static int refill(struct stream *s)
+{
+    struct input *in = s->priv;
+    size_t n = in->end - in->p;
+
+    if (n > STAGE_HALF) {
+        n = STAGE_HALF;
+    }
+    s->p = in->p;
+    s->end = in->p + n;
+    in->p += n;
+    return n;
+}
+
+static u8 *read_file(const char *path, size_t *size)
+{
+    FILE *f;
+    u8 *buf;
+    long len;
+
+    f = fopen(path, "rb");
+    if (!f || fseek(f, 0, SEEK_END) || (len = ftell(f)) < 0
+            || fseek(f, 0, SEEK_SET)) {
+        fprintf(stderr, "%s: can't open %s\n", argv0, path);
+        exit(1);
+    }
+
+    buf = malloc(len ? len : 1);
+    if (!buf || fread(buf, 1, len, f) != (size_t)len) {
+        fprintf(stderr, "%s: error reading %s\n", argv0, path);
+        exit(1);
+    }
+
+    fclose(f);
+    *size = len;
+    return buf;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    int (*decode)(struct stream *s, void *out, size_t max);
+    double card = 20, slowdown = 1, t, best = 0, read_ms, decode_ms;
+    size_t raw_size, packed_size;
+    const char *kind;
+    u8 *raw, *packed, *out;
+    int c, ret = 0;
+
+    argv0 = argv[0];
+    while ((c = getopt(argc, argv, "b:c:")) != -1) {
+        switch (c) {
+        case 'b':
+            card = atof(optarg);
+            break;
+        case 'c':
+            slowdown = atof(optarg);
+            break;
+        default:
+            goto usage;
+        }
+    }
+    if (argc - optind != 2 || card <= 0 || slowdown <= 0) {
+        goto usage;
+    }
+
+    raw = read_file(argv[optind], &raw_size);
+    packed = read_file(argv[optind + 1], &packed_size);
+    out = malloc(raw_size + 1);
+    if (!out) {
+        fprintf(stderr, "%s: out of memory\n", argv0);
+        return 1;
+    }
+
+    if (lz4_probe(packed, packed_size)) {
+        decode = lz4_decode;
+        kind = "lz4";
+    } else if (gunzip_probe(packed, packed_size)) {
+        decode = gunzip_decode;
+        kind = "gzip";
+    } else {
+        fprintf(stderr, "%s: %s is neither lz4 nor gzip\n", argv0,
+                argv[optind + 1]);
+        return 1;
+    }
+
+    for (int i = 0; i < ROUNDS; i++) {
+        struct input in = { packed, packed + packed_size };
+        struct stream s = { .p = packed, .end = packed, .refill = refill,
+                            .priv = &in };
+
+        t = now();
+        ret = decode(&s, out, raw_size + 1);
+        t = now() - t;
+        if (!best || t < best) {
+            best = t;
+        }
+    }
+
+    if (ret != (int)raw_size || memcmp(out, raw, raw_size)) {
+        fprintf(stderr, "%s: %s does not decode to %s (%d)\n", argv0,
+                argv[optind + 1], argv[optind], ret);
+        return 1;
+    }
+
+    printf("%s: %zu bytes, %s: %zu bytes (%.1f%%)\n", argv[optind], raw_size,
+           kind, packed_size, 100.0 * packed_size / raw_size);
+    printf("  %s decode %.0f MB/s on this host\n", kind,
+           raw_size / 1e6 / best);
+    printf("  card at %.1f MB/s, decode %.0fx slower than here:\n", card,
+           slowdown);
+    read_ms = packed_size / 1e3 / card;
+    decode_ms = best * slowdown * 1e3;
+    printf("    raw     %7.1f ms\n", raw_size / 1e3 / card);
+    printf("    %-7s %7.1f ms (read %.1f, decode %.1f)\n", kind,
+           (read_ms > decode_ms ? read_ms : decode_ms)
+           + STAGE_HALF / 1e3 / card, read_ms, decode_ms);
+    return 0;
+
+usage:
+    fprintf(stderr, "usage: %s [-b card MB/s] [-c cpu slowdown] raw "
+            "compressed\n", argv0);
+    return 2;
+}
@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Check nanolib's number formatting against the C library over edge values
+ * and a sweep of random ones, then time it.  The digit loop is also timed
+ * on its own next to the one it replaced, a divide and a modulo by the radix
+ * per digit.  On the host those are single instructions, on the ARM926 they
+ * are calls into libgcc's software divide, so the gap on the board is much
+ * wider than what is shown here.
+ *
+ *   make bench && build/test/bench_printf
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+int nano_vsnprintf(char *str, size_t size, const char *fmt, va_list va);
+int nano_vprintf(const char *fmt, va_list va);
+
+#define ROUNDS      5000000
+
+static unsigned int flushes;
+static size_t flushed;
+
+/* where nano_vprintf hands its buffered output */
+void log_write(const char *buf, size_t len)
+{
+    flushes++;
+    flushed += len;
+}
+
+static int nano_snprintf(char *str, size_t size, const char *fmt, ...)
+{
+    va_list va;
+    int ret;
+
+    va_start(va, fmt);
+    ret = nano_vsnprintf(str, size, fmt, va);
+    va_end(va);
+    return ret;
+}
+
+static int nano_printf(const char *fmt, ...)
+{
+    va_list va;
+    int ret;
+
+    va_start(va, fmt);
+    ret = nano_vprintf(fmt, va);
+    va_end(va);
+    return ret;
+}
+
+/* the digit loop before it was made division free */
+static char *div_utoa(unsigned int n, char *end, unsigned int radix)
+{
+    char *p = end;
+
+    *p = '\0';
+    do {
+        *--p = "0123456789abcdef"[n % radix];
+        n /= radix;
+    } while (n);
+
+    return p;
+}
+
+/* the loop vprintf.c uses now, a multiply by the reciprocal of 10 */
+static char *mul_utoa(unsigned int n, char *end)
+{
+    unsigned int q;
+    char *p = end;
+
+    *p = '\0';
+    do {
+        q = ((unsigned long long)n * 0xcccccccd) >> 35;
+        *--p = '0' + (n - q * 10);
+        n = q;
+    } while (n);
+
+    return p;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, double start, unsigned int rounds)
+{
+    printf("  %-24s %6.1f ns\n", name, (now() - start) * 1e9 / rounds);
+}
+
+static int check(unsigned int v)
+{
+    static const char *fmts[] = { "%u", "%d", "%x", "%X", "%08x", "%-12d|" };
+    char want[32], got[32];
+    int failures = 0;
+
+    for (size_t i = 0; i < sizeof(fmts) / sizeof(fmts[0]); i++) {
+        snprintf(want, sizeof(want), fmts[i], v);
+        nano_snprintf(got, sizeof(got), fmts[i], v);
+        if (strcmp(want, got)) {
+            fprintf(stderr, "\"%s\" of %u: got \"%s\", expected \"%s\"\n",
+                    fmts[i], v, got, want);
+            failures++;
+        }
+    }
+
+    return failures;
+}
+
+int main(void)
+{
+    static const unsigned int edges[] = {
+        0, 1, 9, 10, 99, 100, 999999999, 1000000000, 0x7fffffff,
+        0x80000000, 4294967289u, 4294967290u, 0xffffffff,
+    };
+    unsigned int seed = 1, sum = 0;
+    int failures = 0;
+    char buf[32];
+    double t;
+
+    for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+        failures += check(edges[i]);
+    }
+    for (int i = 0; i < 1000000 && failures < 10; i++) {
+        seed = seed * 1103515245 + 12345;
+        failures += check(seed ^ (seed >> (i & 31)));
+    }
+    if (failures) {
+        return 1;
+    }
+    printf("formatting matches the C library\n");
+
+    t = now();
+    for (unsigned int i = 0; i < ROUNDS; i++) {
+        sum += *div_utoa(i * 2654435761u, buf + sizeof(buf) - 1, 10);
+    }
+    report("divide loop, decimal", t, ROUNDS);
+
+    t = now();
+    for (unsigned int i = 0; i < ROUNDS; i++) {
+        sum += *mul_utoa(i * 2654435761u, buf + sizeof(buf) - 1);
+    }
+    report("multiply loop, decimal", t, ROUNDS);
+
+    t = now();
+    for (unsigned int i = 0; i < ROUNDS; i++) {
+        sum += nano_snprintf(buf, sizeof(buf), "%u", i * 2654435761u);
+    }
+    report("nano snprintf %u", t, ROUNDS);
+
+    t = now();
+    for (unsigned int i = 0; i < ROUNDS; i++) {
+        sum += snprintf(buf, sizeof(buf), "%u", i * 2654435761u);
+    }
+    report("libc snprintf %u", t, ROUNDS);
+
+    t = now();
+    for (unsigned int i = 0; i < ROUNDS; i++) {
+        sum += nano_snprintf(buf, sizeof(buf), "%08x", i * 2654435761u);
+    }
+    report("nano snprintf %08x", t, ROUNDS);
+
+    t = now();
+    for (unsigned int i = 0; i < ROUNDS / 10; i++) {
+        sum += nano_printf("loading %s... loaded %u bytes\n", "zImage",
+                           i * 2654435761u);
+    }
+    printf("  %-24s %6.1f ns, %.1f bytes per write\n", "nano printf line",
+           (now() - t) * 1e9 / (ROUNDS / 10), (double)flushed / flushes);
+
+    return sum == 0;
+}
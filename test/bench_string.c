@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Throughput of nanolib's memcpy, memset and memmove next to a plain byte
+ * loop and the C library, for co-aligned and misaligned buffers.  The word
+ * and block paths are plain C on the host, so this shows the effect of the
+ * alignment handling rather than of the ldm/stm bursts.
+ *
+ *   make bench && build/test/bench_string
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+void *nano_memcpy(void *dest, const void *src, size_t n);
+void *nano_memmove(void *dest, const void *src, size_t n);
+void *nano_memset(void *s, int c, size_t n);
+
+#define TOTAL       (64 * 1024 * 1024)
+
+static unsigned char src[128 * 1024 + 64] __attribute__((aligned(32)));
+static unsigned char dst[128 * 1024 + 64] __attribute__((aligned(32)));
+
+static void *byte_memcpy(void *dest, const void *s, size_t n)
+{
+    volatile unsigned char *d = dest;
+    const unsigned char *p = s;
+
+    while (n--) {
+        *d++ = *p++;
+    }
+
+    return dest;
+}
+
+static void *byte_memset(void *s, int c, size_t n)
+{
+    volatile unsigned char *p = s;
+
+    while (n--) {
+        *p++ = c;
+    }
+
+    return s;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+typedef void *(*copy_fn)(void *, const void *, size_t);
+typedef void *(*set_fn)(void *, int, size_t);
+
+static void bench_copy(const char *name, copy_fn fn, size_t len, int so,
+                       int doff)
+{
+    size_t rounds = TOTAL / len;
+    double t = now();
+
+    for (size_t i = 0; i < rounds; i++) {
+        fn(dst + doff, src + so, len);
+        __asm__ volatile("" : : "r" (dst) : "memory");
+    }
+
+    t = now() - t;
+    printf("  %-14s %7.0f MB/s  %6.3f ns/byte\n", name,
+           rounds * len / 1e6 / t, t * 1e9 / (rounds * len));
+}
+
+/* an overlapping move to a higher address, which has to run backwards */
+static void bench_move(const char *name, copy_fn fn, size_t len, int so,
+                       int doff)
+{
+    size_t rounds = TOTAL / len;
+    double t = now();
+
+    for (size_t i = 0; i < rounds; i++) {
+        fn(dst + 8 + doff, dst + so, len);
+        __asm__ volatile("" : : "r" (dst) : "memory");
+    }
+
+    t = now() - t;
+    printf("  %-14s %7.0f MB/s  %6.3f ns/byte\n", name,
+           rounds * len / 1e6 / t, t * 1e9 / (rounds * len));
+}
+
+static void bench_set(const char *name, set_fn fn, size_t len, int off)
+{
+    size_t rounds = TOTAL / len;
+    double t = now();
+
+    for (size_t i = 0; i < rounds; i++) {
+        fn(dst + off, 0x5a, len);
+        __asm__ volatile("" : : "r" (dst) : "memory");
+    }
+
+    t = now() - t;
+    printf("  %-14s %7.0f MB/s  %6.3f ns/byte\n", name,
+           rounds * len / 1e6 / t, t * 1e9 / (rounds * len));
+}
+
+int main(void)
+{
+    static const size_t lens[] = { 16, 64, 512, 4096, 128 * 1024 };
+    static const int offs[][2] = { { 0, 0 }, { 1, 1 }, { 1, 0 }, { 3, 2 } };
+
+    for (size_t l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) {
+        for (size_t o = 0; o < sizeof(offs) / sizeof(offs[0]); o++) {
+            int so = offs[o][0], doff = offs[o][1];
+
+            printf("copy %zu bytes, src +%d, dest +%d\n", lens[l], so, doff);
+            bench_copy("byte loop", byte_memcpy, lens[l], so, doff);
+            bench_copy("nano memcpy", nano_memcpy, lens[l], so, doff);
+            bench_copy("libc memcpy", memcpy, lens[l], so, doff);
+            bench_move("nano memmove", nano_memmove, lens[l], so, doff);
+            bench_move("libc memmove", memmove, lens[l], so, doff);
+        }
+
+        printf("set %zu bytes\n", lens[l]);
+        bench_set("byte loop", byte_memset, lens[l], 1);
+        bench_set("nano memset", nano_memset, lens[l], 1);
+        bench_set("libc memset", memset, lens[l], 1);
+    }
+
+    return 0;
+}
@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Run hsmmc.c against the register model in hsmmc_model.c.  Each kind of
+ * card is brought up from the state the iROM leaves it in, then read and
+ * written in runs either side of the 32 KB descriptor limit, and what lands
+ * in memory and on the card is checked word for word.
+ *
+ *   make test
+ */
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+
+#include "hsmmc.h"
+#include "hsmmc_model.h"
+
+#define CARD_BLOCKS 4096
+#define MAX_BLOCKS  1024
+#define GUARD       128
+#define FILL        0xa5a5a5a5
+
+/* the model DMAs to 32-bit addresses, which static data has */
+static u32 buf[GUARD + MAX_BLOCKS * 128 + GUARD];
+static u8 card[CARD_BLOCKS * 512];
+static u8 image[CARD_BLOCKS * 512];
+
+static const char *name;
+static int failures;
+
+static void fail(const char *fmt, ...)
+{
+    va_list va;
+
+    fprintf(stderr, "%s: ", name);
+    va_start(va, fmt);
+    vfprintf(stderr, fmt, va);
+    va_end(va);
+    fprintf(stderr, "\n");
+    failures++;
+}
+
+static void fill(void)
+{
+    for (size_t i = 0; i < sizeof(buf) / sizeof(buf[0]); i++) {
+        buf[i] = FILL;
+    }
+}
+
+/* the run at start is in the buffer, and the guards either side untouched */
+static void check_buffer(const char *what, u32 start, u32 count)
+{
+    for (u32 i = 0; i < GUARD; i++) {
+        if (buf[i] != FILL || buf[GUARD + count * 128 + i] != FILL) {
+            fail("%s %u+%u: wrote outside the buffer", what, start, count);
+            return;
+        }
+    }
+
+    if (memcmp(buf + GUARD, card + start * 512, count * 512)) {
+        fail("%s %u+%u: data doesn't match the card", what, start, count);
+    }
+}
+
+static void check_read(u32 start, u32 count)
+{
+    int ret;
+
+    fill();
+    ret = hsmmc_read_blocks(start, count, buf + GUARD);
+    if (ret) {
+        fail("read %u+%u returned %d", start, count, ret);
+        return;
+    }
+    check_buffer("read", start, count);
+}
+
+static void check_reads(void)
+{
+    static const u32 runs[][2] = {
+        { 0, 1 }, { 1, 2 }, { 7, 3 }, { 100, 63 }, { 200, 64 }, { 300, 65 },
+        { 400, 127 }, { 513, 128 }, { 700, 129 }, { 1000, MAX_BLOCKS },
+        { CARD_BLOCKS - 1, 1 },
+    };
+
+    for (size_t i = 0; i < sizeof(runs) / sizeof(runs[0]); i++) {
+        check_read(runs[i][0], runs[i][1]);
+    }
+}
+
+static void check_errors(void)
+{
+    unsigned long commands;
+    int ret;
+
+    ret = hsmmc_read_blocks(CARD_BLOCKS - 1, 2, buf + GUARD);
+    if (ret != -EIO) {
+        fail("read past the end returned %d", ret);
+    }
+    check_read(CARD_BLOCKS - 2, 2);
+
+    commands = model_stats.commands;
+    ret = hsmmc_read_blocks(0, 0, buf + GUARD);
+    if (ret || model_stats.commands != commands) {
+        fail("read of no blocks returned %d", ret);
+    }
+
+    ret = hsmmc_read_blocks(0, HSMMC_MAX_BLKCNT + 1, buf + GUARD);
+    if (ret != -EINVAL) {
+        fail("oversized read returned %d", ret);
+    }
+}
+
+/* the data only lands once the wait has let the transfer run */
+static void check_overlap(void)
+{
+    int ret;
+
+    model_latency = 100;
+    fill();
+
+    ret = hsmmc_read_start(300, 65, buf + GUARD);
+    if (ret) {
+        fail("read start returned %d", ret);
+    } else if (buf[GUARD] != FILL) {
+        fail("read start didn't leave the transfer running");
+    } else if ((ret = hsmmc_read_start(100, 63, buf)) != -EBUSY) {
+        fail("read start over a running transfer returned %d", ret);
+    } else if ((ret = hsmmc_read_wait())) {
+        fail("read wait returned %d", ret);
+    } else {
+        check_buffer("started read", 300, 65);
+    }
+
+    model_latency = 4;
+}
+
+static void check_write(u32 start, u32 count)
+{
+    int ret;
+
+    fill();
+    for (u32 i = 0; i < count * 128; i++) {
+        buf[GUARD + i] = (start + i) * 2654435761u;
+    }
+
+    ret = hsmmc_write_blocks(start, count, buf + GUARD);
+    if (ret) {
+        fail("write %u+%u returned %d", start, count, ret);
+        return;
+    }
+    check_buffer("write", start, count);
+
+    /* and nothing either side of it on the card changed */
+    if (memcmp(card, image, start * 512)
+            || memcmp(card + (start + count) * 512,
+                      image + (start + count) * 512,
+                      (CARD_BLOCKS - start - count) * 512)) {
+        fail("write %u+%u: wrote outside the run", start, count);
+    }
+    memcpy(image + start * 512, card + start * 512, count * 512);
+
+    check_read(start, count);
+}
+
+static void check_writes(void)
+{
+    check_write(5, 1);
+    check_write(64, 64);
+    check_write(1000, 130);
+}
+
+static void check_card(const char *what, struct model_card *c, bool wide,
+                       unsigned int sdclk)
+{
+    unsigned int irom;
+    int ret;
+
+    name = what;
+    memcpy(card, image, sizeof(card));
+    c->data = card;
+    c->blocks = CARD_BLOCKS;
+    model_reset(c);
+    irom = model_sdclk();
+
+    ret = hsmmc_init();
+    if (ret) {
+        fail("init returned %d", ret);
+        return;
+    }
+
+    if (!model_selected()) {
+        fail("card left deselected");
+        return;
+    }
+    if (model_wide() != wide) {
+        fail("bus is %d bits wide", model_wide() ? 4 : 1);
+    }
+    if (model_sdclk() != (sdclk ? sdclk : irom)) {
+        fail("SDCLK at %u Hz", model_sdclk());
+    }
+
+    check_reads();
+    check_errors();
+    check_overlap();
+    check_writes();
+
+    if (model_errors()) {
+        fail("%d errors in the model", model_errors());
+    }
+}
+
+/* a card that can't be selected again must fail init, not reads later */
+static void check_lost_card(const char *what, struct model_card *c)
+{
+    int ret;
+
+    name = what;
+    c->data = card;
+    c->blocks = CARD_BLOCKS;
+    model_reset(c);
+
+    ret = hsmmc_init();
+    if (ret == 0) {
+        fail("init succeeded with the card deselected");
+    }
+}
+
+int main(void)
+{
+    struct model_card sdhc = { .high_capacity = true };
+    struct model_card sd = { 0 };
+    struct model_card no_hs = { .high_capacity = true, .no_high_speed = true };
+    struct model_card slow = { .high_capacity = true, .slow = true };
+    struct model_card mmc = { .mmc = true };
+    struct model_card rca = { .high_capacity = true, .rca_failures = 2 };
+    struct model_card lost = { .high_capacity = true, .rca_failures = 3 };
+
+    /* a register access the model gets wrong could spin forever */
+    alarm(60);
+
+    for (size_t i = 0; i < sizeof(image); i++) {
+        image[i] = i * 7 + (i >> 9);
+    }
+
+    check_card("SDHC", &sdhc, true, 48000000);
+    check_card("SD", &sd, true, 48000000);
+    check_card("SD without high speed", &no_hs, true, 0);
+    check_card("SD that fails at 50 MHz", &slow, true, 0);
+    check_card("MMC", &mmc, false, 0);
+    check_card("SD that misses CMD3", &rca, true, 48000000);
+    check_lost_card("SD that never answers CMD3", &lost);
+
+    if (failures) {
+        fprintf(stderr, "hsmmc: %d failures\n", failures);
+        return 1;
+    }
+
+    printf("hsmmc: ok\n");
+    return 0;
+}
@@ -0,0 +1,716 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Register model of the HSMMC1 controller with a card behind it, so hsmmc.c
+ * can run on the host.  The register page is mapped at its bus address
+ * with no access rights, and every access the driver makes faults.  The
+ * fault handler brings the page up to date for a read, opens it, and lets
+ * the one instruction run under the trap flag; the trap that follows hands
+ * any value written to the model and closes the page again.
+ *
+ * Commands complete at once.  DMA transfers complete after model_latency
+ * status polls, and only then is the descriptor table walked and the data
+ * moved, as the ADMA engine does it while the CPU carries on; whatever it
+ * touches must have been cleaned or invalidated from the D-cache by then.
+ * Anything the real controller or card would not put up with is reported
+ * and counted as an error.
+ */
+
+#define _GNU_SOURCE
+#include <signal.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+
+#include "s3c2450.h"
+#include "clock.h"
+#include "mmu.h"
+#include "movi.h"
+#include "serial.h"
+#include "timer.h"
+#include "hsmmc_model.h"
+
+#if !defined(__x86_64__) || !defined(__linux__)
+#error the register model traps accesses the x86-64 Linux way
+#endif
+
+#define PAGE_SIZE       4096
+#define TF              0x100
+
+#define REG(a)          ((a) - ELFIN_HSMMC_BASE)
+#define R8(a)           (*(u8 *)&shadow[REG(a)])
+#define R16(a)          (*(u16 *)&shadow[REG(a)])
+#define R32(a)          (*(u32 *)&shadow[REG(a)])
+
+/* ERRINTSTS bits */
+#define ERR_CMDTOUT     (1 << 0)
+#define ERR_DATCRC      (1 << 5)
+#define ERR_ADMA        (1 << 9)
+
+/* card states, as R1 reports them */
+#define STATE_STBY      3
+#define STATE_TRAN      4
+#define STATE_DATA      5
+#define STATE_RCV       6
+
+#define R1_OUT_OF_RANGE (1u << 31)
+#define R1_ILLEGAL      (1 << 22)
+#define R1_READY        (1 << 8)
+#define R1_APP_CMD      (1 << 5)
+
+#define HCLK            133000000
+#define EPLL_HSMMC      48000000
+
+struct model_stats model_stats;
+unsigned int model_latency = 4;
+
+static u8 *const page = (u8 *)ELFIN_HSMMC_BASE;
+static u8 shadow[PAGE_SIZE];
+
+/* the access being single-stepped */
+static u32 access_reg;
+static bool access_write;
+
+/* ranges cleaned and invalidated since the last transfer */
+struct range {
+    u32 start, end;
+};
+static struct range cleaned[8], invalidated[8];
+static int ncleaned, ninvalidated;
+
+static struct {
+    struct model_card card;
+    int errors;
+
+    /* the card */
+    int state;
+    u16 rca;
+    bool app_cmd;
+    bool illegal;
+    bool wide;
+    bool high_speed;
+
+    /* the controller */
+    u16 norint;
+    u16 errint;
+    bool busy;
+    bool write;
+    bool dma;
+    bool bufrden;
+    bool garbled;
+    unsigned int countdown;
+    u32 offset;             /* card byte offset of the current block */
+    u32 blocks;
+    u32 blksize;
+    u32 word;
+    const u8 *pio;          /* PIO data, if not straight from the card */
+    u8 block[512];
+} m;
+
+static void violation(const char *fmt, ...)
+{
+    va_list va;
+
+    fprintf(stderr, "  model: ");
+    va_start(va, fmt);
+    vfprintf(stderr, fmt, va);
+    va_end(va);
+    fprintf(stderr, "\n");
+    m.errors++;
+}
+
+/* the rest of the board hsmmc.c calls into */
+unsigned int clock_get_hsmmc(void)
+{
+    return EPLL_HSMMC;
+}
+
+static void add_range(struct range *r, int *n, u32 start, u32 end)
+{
+    if (*n < 8) {
+        r[*n].start = start;
+        r[*n].end = end;
+        ++*n;
+    }
+}
+
+void dcache_clean_range(u32 start, u32 end)
+{
+    add_range(cleaned, &ncleaned, start, end);
+}
+
+void dcache_inval_range(u32 start, u32 end)
+{
+    add_range(invalidated, &ninvalidated, start, end);
+}
+
+static bool in_range(const struct range *r, int n, u32 start, u32 end)
+{
+    for (int i = 0; i < n; i++) {
+        if (start >= r[i].start && end <= r[i].end) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void serial_poll(void)
+{
+}
+
+u32 timer_ticks(void)
+{
+    return 0;
+}
+
+unsigned int model_sdclk(void)
+{
+    unsigned int base, sel = R16(HM_CLKCON) >> 8;
+
+    if (!(R16(HM_CLKCON) & HM_CLKCON_SDCLKEN)) {
+        return 0;
+    }
+
+    base = (R32(HM_CONTROL2) & HM_CONTROL2_SELBASECLK_MASK)
+            == HM_CONTROL2_SELBASECLK_EPLL ? EPLL_HSMMC : HCLK;
+    return sel ? base / (sel * 2) : base;
+}
+
+bool model_wide(void)
+{
+    return R8(HM_HOSTCTL) & HM_HOSTCTL_WIDE4;
+}
+
+bool model_selected(void)
+{
+    return m.state == STATE_TRAN;
+}
+
+int model_errors(void)
+{
+    return m.errors;
+}
+
+static void set_norint(u16 bits)
+{
+    m.norint |= bits & R16(HM_NORINTSTSEN);
+}
+
+static void set_errint(u16 bits)
+{
+    m.errint |= bits & R16(HM_ERRINTSTSEN);
+}
+
+/* whether data would cross the bus intact at the current settings */
+static bool bus_ok(void)
+{
+    unsigned int sdclk = model_sdclk();
+    unsigned int max = m.high_speed && !m.card.slow ? 50000000 : 25000000;
+
+    if (model_wide() != m.wide) {
+        return false;
+    }
+    if (sdclk > 25000000 && !(R8(HM_HOSTCTL) & HM_HOSTCTL_HSPD)) {
+        return false;
+    }
+    return sdclk <= max;
+}
+
+static u32 r1(void)
+{
+    u32 status = m.state << 9 | R1_READY;
+
+    if (m.illegal) {
+        status |= R1_ILLEGAL;
+        m.illegal = false;
+    }
+    if (m.app_cmd) {
+        status |= R1_APP_CMD;
+    }
+    return status;
+}
+
+static void respond(u32 rsp)
+{
+    R32(HM_RSPREG0) = rsp;
+    set_norint(HM_NORINT_CMDCMPLT);
+}
+
+static void no_response(void)
+{
+    set_errint(ERR_CMDTOUT);
+}
+
+static void finish(void)
+{
+    m.busy = false;
+    m.bufrden = false;
+    m.state = STATE_TRAN;
+    ncleaned = ninvalidated = 0;
+
+    if (m.garbled) {
+        set_errint(ERR_DATCRC);
+    } else {
+        set_norint(HM_NORINT_TRCMPLT);
+    }
+}
+
+static void start_data(bool write, const u8 *pio)
+{
+    u16 trnmod = R16(HM_TRNMOD);
+
+    m.busy = true;
+    m.write = write;
+    m.dma = trnmod & HM_TRNMOD_DMAEN;
+    m.pio = pio;
+    m.word = 0;
+    m.blksize = R16(HM_BLKSIZE) & 0xfff;
+    m.blocks = trnmod & HM_TRNMOD_MULTIBLK ? R16(HM_BLKCNT) : 1;
+    m.garbled = !bus_ok();
+    m.state = write ? STATE_RCV : STATE_DATA;
+
+    if (!(trnmod & HM_TRNMOD_READ) != write) {
+        violation("transfer direction doesn't match CMD%u",
+                  R16(HM_CMDREG) >> 8);
+    }
+    if (trnmod & HM_TRNMOD_MULTIBLK && (!(trnmod & HM_TRNMOD_BLKCNTEN)
+            || !(trnmod & HM_TRNMOD_ACMD12EN))) {
+        violation("open-ended transfer without a block count and CMD12");
+    }
+    if (m.blocks == 0) {
+        violation("transfer of no blocks");
+    }
+
+    if (m.dma) {
+        if ((R8(HM_HOSTCTL) & HM_HOSTCTL_DMASEL_MASK)
+                != HM_HOSTCTL_DMASEL_ADMA2) {
+            violation("DMA without ADMA2 selected");
+        }
+        m.countdown = model_latency;
+    } else if (write) {
+        violation("PIO writes are not modelled");
+    } else if (m.garbled) {
+        finish();
+    } else {
+        m.bufrden = true;
+        set_norint(HM_NORINT_BUFRDRDY);
+    }
+}
+
+/*
+ * Walk the descriptor table and move the data, once the transfer has had
+ * its time on the bus.
+ */
+static void run_adma(void)
+{
+    u32 table = R32(HM_ADMASYSADDR);
+    u32 left = m.blocks * m.blksize;
+    int n;
+
+    for (n = 0; left; n++) {
+        u32 *desc = (u32 *)(uintptr_t)(table + n * 8);
+        u32 attr = desc[0], addr = desc[1], len = attr >> 16;
+
+        if (!in_range(cleaned, ncleaned, table + n * 8, table + n * 8 + 8)) {
+            violation("descriptor %d is not cleaned from the D-cache", n);
+        }
+        if (!(attr & HM_ADMA_VALID) || (attr & (3 << 4)) != HM_ADMA_ACT_TRAN
+                || (addr & 3)) {
+            violation("bad descriptor %d: 0x%08x 0x%08x", n, attr, addr);
+            set_errint(ERR_ADMA);
+            break;
+        }
+
+        len = len ? len : 0x10000;
+        if (len > left) {
+            len = left;
+        }
+        if (m.write) {
+            if (!in_range(cleaned, ncleaned, addr, addr + len)) {
+                violation("0x%08x+%u is written out uncleaned", addr, len);
+            }
+            memcpy(m.card.data + m.offset, (void *)(uintptr_t)addr, len);
+        } else {
+            if (!in_range(invalidated, ninvalidated, addr, addr + len)) {
+                violation("0x%08x+%u is read in uninvalidated", addr, len);
+            }
+            memcpy((void *)(uintptr_t)addr, m.card.data + m.offset, len);
+        }
+        m.offset += len;
+        left -= len;
+
+        if (left && (attr & HM_ADMA_END)) {
+            violation("descriptor table ends %u bytes short", left);
+            set_errint(ERR_ADMA);
+            break;
+        }
+    }
+
+    finish();
+}
+
+/* time passes whenever the driver polls for status */
+static void poll(void)
+{
+    model_stats.polls++;
+
+    if (m.busy && m.dma) {
+        if (m.countdown) {
+            m.countdown--;
+        } else if (m.garbled) {
+            finish();
+        } else {
+            run_adma();
+        }
+    }
+}
+
+static u32 read_bdata(void)
+{
+    u32 word;
+
+    if (!m.bufrden) {
+        violation("BDATA read with no data ready");
+        return 0;
+    }
+
+    if (m.pio) {
+        memcpy(&word, m.pio + m.word * 4, 4);
+    } else {
+        memcpy(&word, m.card.data + m.offset + m.word * 4, 4);
+    }
+
+    if (++m.word * 4 == m.blksize) {
+        m.word = 0;
+        m.offset += m.blksize;
+        if (--m.blocks) {
+            set_norint(HM_NORINT_BUFRDRDY);
+        } else {
+            finish();
+        }
+    }
+
+    return word;
+}
+
+/* check that an addressed block run lies on the card */
+static bool address(u32 arg, u32 count)
+{
+    u32 start = arg;
+
+    if (!m.card.high_capacity) {
+        if (arg & 511) {
+            return false;
+        }
+        start = arg >> 9;
+    }
+
+    if (start >= m.card.blocks || count > m.card.blocks - start) {
+        return false;
+    }
+
+    m.offset = start * 512;
+    return true;
+}
+
+static void command(u16 cmdreg)
+{
+    unsigned int idx = cmdreg >> 8;
+    u32 arg = R32(HM_ARGUMENT);
+    bool app = m.app_cmd;
+    int rsp = cmdreg & 3, want = HM_CMDREG_RSP_48;
+    bool data = cmdreg & HM_CMDREG_DATA, want_data = false;
+    u16 trnmod = R16(HM_TRNMOD);
+    u32 count = trnmod & HM_TRNMOD_MULTIBLK ? R16(HM_BLKCNT) : 1;
+
+    model_stats.commands++;
+    m.app_cmd = false;
+
+    if (m.busy) {
+        violation("CMD%u issued during a transfer", idx);
+        return;
+    }
+    if (!model_sdclk()) {
+        violation("CMD%u issued with SDCLK stopped", idx);
+        no_response();
+        return;
+    }
+
+    switch (idx) {
+    case 3:
+        if (m.card.mmc || m.state != STATE_STBY) {
+            no_response();
+        } else if (m.card.rca_failures > 0) {
+            m.card.rca_failures--;
+            no_response();
+        } else {
+            m.rca++;
+            respond(m.rca << 16 | (m.illegal ? 1 << 14 : 0) | m.state << 9
+                    | R1_READY);
+            m.illegal = false;
+        }
+        break;
+
+    case 6:
+        if (app) {
+            if (m.state != STATE_TRAN) {
+                no_response();
+                break;
+            }
+            m.wide = (arg & 3) == 2;
+            respond(r1() | R1_APP_CMD);
+            break;
+        }
+
+        want_data = true;
+        if (m.card.mmc || m.state != STATE_TRAN) {
+            m.illegal = true;
+            no_response();
+            break;
+        }
+        if (R16(HM_BLKSIZE) != 64) {
+            violation("CMD6 status block size %u", R16(HM_BLKSIZE));
+        }
+        memset(m.block, 0, sizeof(m.block));
+        if ((arg & 0x8000000f) == 0x80000001 && !m.card.no_high_speed) {
+            m.high_speed = true;
+            m.block[16] = 1;
+        }
+        respond(r1());
+        start_data(false, m.block);
+        break;
+
+    case 7:
+        want = arg >> 16 ? HM_CMDREG_RSP_48B : HM_CMDREG_RSP_NONE;
+        if (!(arg >> 16)) {
+            if (m.state == STATE_TRAN) {
+                m.state = STATE_STBY;
+            }
+            set_norint(HM_NORINT_CMDCMPLT);
+        } else if (arg >> 16 == m.rca && m.state == STATE_STBY) {
+            respond(r1());
+            m.state = STATE_TRAN;
+        } else {
+            no_response();
+        }
+        break;
+
+    case 8:
+        want_data = true;
+        if (!m.card.mmc || m.state != STATE_TRAN) {
+            m.illegal = true;
+            no_response();
+            break;
+        }
+        memset(m.block, 0, sizeof(m.block));
+        respond(r1());
+        start_data(false, m.block);
+        break;
+
+    case 18:
+    case 25:
+        want_data = true;
+        if (m.state != STATE_TRAN) {
+            no_response();
+        } else if (!address(arg, count)) {
+            respond(r1() | R1_OUT_OF_RANGE);
+        } else {
+            respond(r1());
+            start_data(idx == 25, NULL);
+        }
+        break;
+
+    case 55:
+        if (m.card.mmc || arg >> 16 != m.rca || m.state != STATE_TRAN) {
+            no_response();
+            break;
+        }
+        m.app_cmd = true;
+        respond(r1());
+        break;
+
+    default:
+        violation("unexpected CMD%u", idx);
+        no_response();
+        return;
+    }
+
+    if (rsp != want || data != want_data) {
+        violation("CMD%u sent with response type %d%s", idx, rsp,
+                  data ? " and data" : "");
+    }
+}
+
+static void write_reg(u32 reg)
+{
+    switch (reg) {
+    case REG(HM_CMDREG):
+        command(R16(HM_CMDREG));
+        break;
+
+    case REG(HM_NORINTSTS):
+        m.norint &= ~R16(HM_NORINTSTS);
+        break;
+
+    case REG(HM_ERRINTSTS):
+        m.errint &= ~R16(HM_ERRINTSTS);
+        break;
+
+    case REG(HM_SWRST):
+        if (R8(HM_SWRST) & HM_SWRST_DAT) {
+            m.busy = false;
+            m.bufrden = false;
+            if (m.state == STATE_DATA || m.state == STATE_RCV) {
+                m.state = STATE_TRAN;
+            }
+        }
+        R8(HM_SWRST) = 0;
+        break;
+
+    case REG(HM_CLKCON):
+        if (R16(HM_CLKCON) & HM_CLKCON_ICLKEN) {
+            R16(HM_CLKCON) |= HM_CLKCON_ICLKSTA;
+        } else {
+            R16(HM_CLKCON) &= ~HM_CLKCON_ICLKSTA;
+        }
+        break;
+
+    case REG(HM_BDATA):
+        violation("BDATA written");
+        break;
+    }
+}
+
+/* bring the registers whose value the model keeps elsewhere up to date */
+static void update(u32 reg, bool read)
+{
+    if (read) {
+        if (reg == REG(HM_NORINTSTS) || reg == REG(HM_PRNSTS)) {
+            poll();
+        }
+        if (reg == REG(HM_BDATA)) {
+            R32(HM_BDATA) = read_bdata();
+        }
+    }
+
+    R16(HM_NORINTSTS) = m.norint | (m.errint ? HM_NORINT_ERR : 0);
+    R16(HM_ERRINTSTS) = m.errint;
+    R32(HM_PRNSTS) = (m.busy ? HM_PRNSTS_CMDINHDAT : 0)
+                   | (m.bufrden ? HM_PRNSTS_BUFRDEN : 0);
+}
+
+static void segv(int sig, siginfo_t *si, void *ctx)
+{
+    ucontext_t *uc = ctx;
+    uintptr_t addr = (uintptr_t)si->si_addr;
+
+    if (addr < ELFIN_HSMMC_BASE || addr >= ELFIN_HSMMC_BASE + PAGE_SIZE) {
+        /* not a register: fault again, this time for real */
+        signal(SIGSEGV, SIG_DFL);
+        return;
+    }
+
+    access_reg = addr - ELFIN_HSMMC_BASE;
+    access_write = uc->uc_mcontext.gregs[REG_ERR] & 2;
+    if (access_write) {
+        model_stats.writes++;
+    } else {
+        model_stats.reads++;
+    }
+
+    update(access_reg, !access_write);
+
+    mprotect(page, PAGE_SIZE, PROT_READ | PROT_WRITE);
+    memcpy(page, shadow, PAGE_SIZE);
+    uc->uc_mcontext.gregs[REG_EFL] |= TF;
+}
+
+static void trap(int sig, siginfo_t *si, void *ctx)
+{
+    ucontext_t *uc = ctx;
+
+    uc->uc_mcontext.gregs[REG_EFL] &= ~TF;
+
+    if (access_write) {
+        memcpy(shadow, page, PAGE_SIZE);
+        write_reg(access_reg);
+    }
+
+    mprotect(page, PAGE_SIZE, PROT_NONE);
+}
+
+static void model_init(void)
+{
+    struct sigaction sa = { .sa_flags = SA_SIGINFO };
+
+    if (mmap(page, PAGE_SIZE, PROT_NONE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0)
+            != page
+            || mmap((void *)((TCM_BASE - 8) & ~(PAGE_SIZE - 1)), PAGE_SIZE,
+                    PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0)
+            == MAP_FAILED) {
+        perror("model: mmap");
+        exit(1);
+    }
+
+    sa.sa_sigaction = segv;
+    sigaction(SIGSEGV, &sa, NULL);
+    sa.sa_sigaction = trap;
+    sigaction(SIGTRAP, &sa, NULL);
+}
+
+/*
+ * Put the controller and card in the state the iROM leaves them in: card
+ * selected on a 1-bit bus at about 17 MHz, and stale status from its last
+ * transfer.
+ */
+void model_reset(const struct model_card *card)
+{
+    static bool mapped;
+
+    if (!mapped) {
+        model_init();
+        mapped = true;
+    }
+
+    memset(&m, 0, sizeof(m));
+    memset(shadow, 0, sizeof(shadow));
+    memset(&model_stats, 0, sizeof(model_stats));
+    ncleaned = ninvalidated = 0;
+
+    m.card = *card;
+    m.state = STATE_TRAN;
+    m.rca = 1;
+
+    R16(HM_CLKCON) = HM_CLKCON_SDCLKSEL(4) | HM_CLKCON_SDCLKEN
+                   | HM_CLKCON_ICLKSTA | HM_CLKCON_ICLKEN;
+    R16(HM_NORINTSTSEN) = 0xffff;
+    R16(HM_ERRINTSTSEN) = 0xffff;
+    m.norint = HM_NORINT_CMDCMPLT | HM_NORINT_TRCMPLT;
+
+    MOVI_HIGH_CAPACITY = card->high_capacity;
+}
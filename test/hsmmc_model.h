@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __HSMMC_MODEL_H
+#define __HSMMC_MODEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* the card in the slot, and how it answers */
+struct model_card {
+    uint8_t *data;
+    uint32_t blocks;
+    bool high_capacity;     /* addressed in blocks rather than bytes */
+    bool mmc;               /* an MMC, which has no RCA to publish */
+    bool no_high_speed;     /* refuses the CMD6 switch to high speed */
+    bool slow;              /* switches, but garbles data above 25 MHz */
+    int rca_failures;       /* CMD3s that go unanswered */
+};
+
+/* register accesses and commands since the last model_reset() */
+struct model_stats {
+    unsigned long reads;
+    unsigned long writes;
+    unsigned long polls;
+    unsigned long commands;
+};
+
+extern struct model_stats model_stats;
+
+/* status polls a DMA transfer takes to complete */
+extern unsigned int model_latency;
+
+void model_reset(const struct model_card *card);
+int model_errors(void);
+
+unsigned int model_sdclk(void);
+bool model_wide(void);
+bool model_selected(void);
+
+#endif /* __HSMMC_MODEL_H */
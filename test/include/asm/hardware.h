@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Board registers are 32 bits wide, which unsigned long is not on a 64-bit
+ * host.  Board sources built for the host tests find this header ahead of
+ * nanolib's.
+ */
+
+#ifndef _TEST_ASM_HARDWARE_H_
+#define _TEST_ASM_HARDWARE_H_
+
+#include_next <asm/hardware.h>
+
+#ifndef __ASSEMBLY__
+#undef __REG
+#undef __REGl
+#undef __REG2
+#define __REG(x) (*(volatile unsigned int *)(x))
+#define __REGl(x) (*(volatile unsigned int *)(x))
+#define __REG2(x,y) (*(volatile unsigned int *)((x) + (y)))
+#endif
+
+#endif /* _TEST_ASM_HARDWARE_H_ */
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Check nanolib's memcpy, memset and memmove against every source and
+ * destination alignment and lengths either side of the word and 32-byte
+ * block paths, including memmove overlaps in both directions.  The nanolib
+ * copies are built renamed with a nano_ prefix so they sit beside the C
+ * library's.
+ *
+ *   make test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void *nano_memcpy(void *dest, const void *src, size_t n);
+void *nano_memmove(void *dest, const void *src, size_t n);
+void *nano_memset(void *s, int c, size_t n);
+
+#define MAX_LEN     300
+#define GUARD       16
+#define BUF_SIZE    (GUARD + 8 + MAX_LEN + 64 + GUARD)
+
+static unsigned char src[BUF_SIZE] __attribute__((aligned(32)));
+static unsigned char dst[BUF_SIZE] __attribute__((aligned(32)));
+static unsigned char want[BUF_SIZE] __attribute__((aligned(32)));
+
+static int failures;
+
+static void fill(unsigned char *buf, size_t len, unsigned int seed)
+{
+    for (size_t i = 0; i < len; i++) {
+        seed = seed * 1103515245 + 12345;
+        buf[i] = seed >> 16;
+    }
+}
+
+static void check(const char *fn, int a, int b, size_t len, const void *ret,
+                  const void *want_ret)
+{
+    if (ret != want_ret) {
+        fprintf(stderr, "%s(%d, %d, %zu): returned %p, not %p\n", fn, a, b,
+                len, ret, want_ret);
+        failures++;
+    } else if (memcmp(dst, want, BUF_SIZE)) {
+        fprintf(stderr, "%s(%d, %d, %zu): wrong contents\n", fn, a, b, len);
+        failures++;
+    }
+}
+
+static void test_memcpy(void)
+{
+    fill(src, BUF_SIZE, 1);
+
+    for (int so = 0; so < 8; so++) {
+        for (int doff = 0; doff < 8; doff++) {
+            for (size_t len = 0; len <= MAX_LEN; len++) {
+                memset(dst, 0xa5, BUF_SIZE);
+                memset(want, 0xa5, BUF_SIZE);
+                memcpy(want + GUARD + doff, src + GUARD + so, len);
+                check("memcpy", doff, so, len,
+                      nano_memcpy(dst + GUARD + doff, src + GUARD + so, len),
+                      dst + GUARD + doff);
+            }
+        }
+    }
+}
+
+static void test_memset(void)
+{
+    static const int values[] = { 0, 0xff, 0x5a, 0x1c3 };
+
+    for (int v = 0; v < 4; v++) {
+        for (int off = 0; off < 8; off++) {
+            for (size_t len = 0; len <= MAX_LEN; len++) {
+                memset(dst, 0xa5, BUF_SIZE);
+                memset(want, 0xa5, BUF_SIZE);
+                memset(want + GUARD + off, values[v], len);
+                check("memset", off, values[v], len,
+                      nano_memset(dst + GUARD + off, values[v], len),
+                      dst + GUARD + off);
+            }
+        }
+    }
+}
+
+/* source and destination in the same buffer, up to 40 bytes apart */
+static void test_memmove(void)
+{
+    for (int so = 0; so < 40; so++) {
+        for (int doff = 0; doff < 40; doff++) {
+            for (size_t len = 0; len <= MAX_LEN - 40; len++) {
+                fill(dst, BUF_SIZE, so * 40 + doff);
+                memcpy(want, dst, BUF_SIZE);
+                memmove(want + GUARD + doff, want + GUARD + so, len);
+                check("memmove", doff, so, len,
+                      nano_memmove(dst + GUARD + doff, dst + GUARD + so, len),
+                      dst + GUARD + doff);
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    test_memcpy();
+    test_memset();
+    test_memmove();
+
+    if (failures) {
+        fprintf(stderr, "string: %d failures\n", failures);
+        return 1;
+    }
+
+    printf("string: ok\n");
+    return 0;
+}
@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2015 Jeff Kent <jeff@jkent.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Pack a kernel, initramfs, device tree and command line into a nanoboot
+ * image, see include/nbimg.h.
+ *
+ *   mknbimg [-s] -k zImage[@addr] [-i initramfs[@addr]] [-d dtb[@addr]]
+ *           [-c cmdline] out.nbi
+ *
+ * The header is written in host byte order, so this has to run on a little
+ * endian host.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef uint8_t u8;
+typedef uint32_t u32;
+typedef unsigned long long u64;
+
+#include "crc32.h"
+#include "nbimg.h"
+#include "sha256.h"
+
+static const char *argv0;
+
+static struct {
+    __u32 type;
+    const char *path;       /* NULL for the command line */
+    const char *text;
+    __u32 load_address;
+} inputs[NBIMG_MAX_PARTS];
+static int ninputs;
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: %s [-s] -k zImage[@addr] [-i initramfs[@addr]] "
+            "[-d dtb[@addr]] [-c cmdline] out.nbi\n"
+            "  -s  add SHA-256 checksums, CRC-32 is always added\n",
+            argv0);
+    exit(2);
+}
+
+static void add_input(__u32 type, char *arg)
+{
+    char *at, *end;
+
+    if (ninputs == NBIMG_MAX_PARTS) {
+        fprintf(stderr, "%s: too many parts\n", argv0);
+        exit(1);
+    }
+
+    inputs[ninputs].type = type;
+    if (type == NBIMG_CMDLINE) {
+        inputs[ninputs].text = arg;
+    } else {
+        at = strrchr(arg, '@');
+        if (at) {
+            *at++ = '\0';
+            inputs[ninputs].load_address = strtoul(at, &end, 0);
+            if (!*at || *end) {
+                fprintf(stderr, "%s: bad load address \"%s\"\n", argv0, at);
+                exit(1);
+            }
+        }
+        inputs[ninputs].path = arg;
+    }
+    ninputs++;
+}
+
+static u8 *read_file(const char *path, size_t *size)
+{
+    FILE *f;
+    u8 *buf;
+    long len;
+
+    f = fopen(path, "rb");
+    if (!f || fseek(f, 0, SEEK_END) || (len = ftell(f)) < 0
+            || fseek(f, 0, SEEK_SET)) {
+        fprintf(stderr, "%s: %s: %s\n", argv0, path, strerror(errno));
+        exit(1);
+    }
+
+    buf = malloc(len ? len : 1);
+    if (!buf || fread(buf, 1, len, f) != (size_t)len) {
+        fprintf(stderr, "%s: error reading %s\n", argv0, path);
+        exit(1);
+    }
+
+    fclose(f);
+    *size = len;
+    return buf;
+}
+
+static void write_all(FILE *f, const void *buf, size_t len, const char *path)
+{
+    if (fwrite(buf, 1, len, f) != len) {
+        fprintf(stderr, "%s: error writing %s\n", argv0, path);
+        exit(1);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    static u8 block[NBIMG_ALIGN];
+    static const u8 zero[NBIMG_ALIGN];
+    struct nbimg_header *hdr = (struct nbimg_header *)block;
+    struct nbimg_part *parts = (struct nbimg_part *)(hdr + 1);
+    struct sha256_ctx sha;
+    u8 *data[NBIMG_MAX_PARTS];
+    size_t size, pad;
+    __u32 offset = NBIMG_ALIGN;
+    int sha256 = 0, have_kernel = 0;
+    const char *out;
+    FILE *f;
+    int c, i;
+
+    argv0 = argv[0];
+
+    while ((c = getopt(argc, argv, "sk:i:d:c:")) != -1) {
+        switch (c) {
+        case 's':
+            sha256 = 1;
+            break;
+        case 'k':
+            add_input(NBIMG_KERNEL, optarg);
+            have_kernel = 1;
+            break;
+        case 'i':
+            add_input(NBIMG_INITRAMFS, optarg);
+            break;
+        case 'd':
+            add_input(NBIMG_DTB, optarg);
+            break;
+        case 'c':
+            add_input(NBIMG_CMDLINE, optarg);
+            break;
+        default:
+            usage();
+        }
+    }
+
+    if (optind != argc - 1 || !have_kernel) {
+        usage();
+    }
+    out = argv[optind];
+
+    for (i = 0; i < ninputs; i++) {
+        if (inputs[i].path) {
+            data[i] = read_file(inputs[i].path, &size);
+        } else {
+            data[i] = (u8 *)inputs[i].text;
+            size = strlen(inputs[i].text);
+        }
+        if (size > UINT32_MAX - offset) {
+            fprintf(stderr, "%s: image too large\n", argv0);
+            exit(1);
+        }
+
+        parts[i].type = inputs[i].type;
+        parts[i].flags = NBIMG_CRC32;
+        parts[i].offset = offset;
+        parts[i].size = size;
+        parts[i].load_address = inputs[i].load_address;
+        parts[i].crc32 = crc32(0, data[i], size);
+        if (sha256) {
+            parts[i].flags |= NBIMG_SHA256;
+            sha256_init(&sha);
+            sha256_update(&sha, data[i], size);
+            sha256_final(&sha, parts[i].sha256);
+        }
+
+        offset += (size + NBIMG_ALIGN - 1) & ~(NBIMG_ALIGN - 1);
+    }
+
+    hdr->magic = NBIMG_MAGIC;
+    hdr->version = NBIMG_VERSION;
+    hdr->count = ninputs;
+    hdr->crc32 = crc32(0, parts, ninputs * sizeof(*parts));
+
+    f = fopen(out, "wb");
+    if (!f) {
+        fprintf(stderr, "%s: %s: %s\n", argv0, out, strerror(errno));
+        exit(1);
+    }
+
+    write_all(f, block, sizeof(block), out);
+    for (i = 0; i < ninputs; i++) {
+        write_all(f, data[i], parts[i].size, out);
+        pad = -parts[i].size & (NBIMG_ALIGN - 1);
+        write_all(f, zero, pad, out);
+    }
+
+    if (fclose(f)) {
+        fprintf(stderr, "%s: error writing %s\n", argv0, out);
+        exit(1);
+    }
+
+    return 0;
+}